@@ -1,223 +1,917 @@
+// HTTP adapter over the data engine (engine.h): Crow routes, JSON
+// serialization, result cache, request coalescing, CORS, metrics and the slow
+// query log. Handlers parse parameters, call the engine's query and mutation
+// functions (which lock the dataset themselves) and turn the results into
+// JSON.
+
+#include "engine.h"
+
+#ifndef CROW_USE_BOOST
 #define CROW_USE_BOOST
+#endif
 #include "crow_all.h"
-#include <cstdlib>
-
-#include <fstream>
-#include <sstream>
-#include <string>
-#include <vector>
-#include <unordered_map>
-#include <iostream>
-#include <algorithm>
-#include <cmath>
-#include <utility>
-
-// ---------- Constants ----------
-
-const double PI = 3.14159265358979323846;
-
-// ---------- Data Structures ----------
-
-struct Airline {
-    int id = -1;
-    std::string name;
-    std::string alias;
-    std::string iata;
-    std::string icao;
-    std::string callsign;
-    std::string country;
-    std::string active;
-};
 
-struct Airport {
-    int id = -1;
-    std::string name;
-    std::string city;
-    std::string country;
-    std::string iata;
-    std::string icao;
-    double latitude  = 0.0;
-    double longitude = 0.0;
-};
+// ---------- JSON Serialization ----------
 
-struct Route {
-    int airlineId    = -1;
-    int srcAirportId = -1;
-    int dstAirportId = -1;
-    int stops        = 0;
-};
+// Engine results to endpoint JSON. crow::json objects are hash maps whose
+// dump order follows insertion, so keep the key order stable: clients and
+// cached bodies compare byte for byte.
+
+crow::json::wvalue errorJson(const std::string& message) {
+    crow::json::wvalue r;
+    r["error"] = message;
+    return r;
+}
+
+crow::json::wvalue utcOffsetJson(int16_t minutes) {
+    if (minutes == UTC_OFFSET_UNKNOWN) return crow::json::wvalue(nullptr);
+    return crow::json::wvalue(minutes / 60.0);
+}
+
+// Adds the elevation, timezone and type columns to an airport JSON object.
+void writeAirportTimeFields(crow::json::wvalue& out, const AirportRecord& ap) {
+    out["altitude_ft"] = ap.altitudeFt;
+    out["utc_offset"]  = utcOffsetJson(ap.utcOffsetMin);
+    out["dst"]    = std::string(1, ap.dst);
+    out["tz"]     = ap.tz;
+    out["type"]   = ap.type;
+    out["source"] = ap.source;
+}
+
+void writeAirlineJson(crow::json::wvalue& r, const AirlineRecord& a) {
+    r["id"]       = a.id;
+    r["name"]     = a.name;
+    r["alias"]    = a.alias;
+    r["iata"]     = a.iata;
+    r["icao"]     = a.icao;
+    r["callsign"] = a.callsign;
+    r["country"]  = a.country;
+    r["active"]   = a.active;
+}
+
+void writeAirportJson(crow::json::wvalue& r, const AirportRecord& ap) {
+    r["id"]        = ap.id;
+    r["name"]      = ap.name;
+    r["city"]      = ap.city;
+    r["country"]   = ap.country;
+    r["iata"]      = ap.iata;
+    r["icao"]      = ap.icao;
+    r["latitude"]  = ap.latitude;
+    r["longitude"] = ap.longitude;
+    writeAirportTimeFields(r, ap);
+}
 
-// ---------- Global Storage ----------
+void writeAirlineJson(JsonWriter& w, const AirlineRecord& a) {
+    w.beginObject()
+        .field("id", a.id)
+        .field("name", a.name)
+        .field("alias", a.alias)
+        .field("iata", a.iata)
+        .field("icao", a.icao)
+        .field("callsign", a.callsign)
+        .field("country", a.country)
+        .field("active", a.active)
+        .endObject();
+}
 
-// airlines
-std::unordered_map<int, Airline> airlinesById;
-std::unordered_map<std::string, Airline*> airlinesByIata;
+void writeAirportJson(JsonWriter& w, const AirportRecord& ap) {
+    w.beginObject()
+        .field("id", ap.id)
+        .field("name", ap.name)
+        .field("city", ap.city)
+        .field("country", ap.country)
+        .field("iata", ap.iata)
+        .field("icao", ap.icao)
+        .field("latitude", ap.latitude)
+        .field("longitude", ap.longitude)
+        .field("altitude_ft", ap.altitudeFt);
+    if (ap.utcOffsetMin == UTC_OFFSET_UNKNOWN) w.key("utc_offset").null();
+    else w.field("utc_offset", ap.utcOffsetMin / 60.0);
+    w.field("dst", std::string_view(&ap.dst, 1))
+        .field("tz", ap.tz)
+        .field("type", ap.type)
+        .field("source", ap.source)
+        .endObject();
+}
 
-// airports
-std::unordered_map<int, Airport> airportsById;
-std::unordered_map<std::string, Airport*> airportsByIata;
+crow::json::wvalue toJson(const AirlineResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue out;
+    writeAirlineJson(out, r.airline);
+    return out;
+}
 
-// routes
-std::vector<Route> routes;
+crow::json::wvalue toJson(const AirportResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue out;
+    writeAirportJson(out, r.airport);
+    return out;
+}
 
-// ---------- CSV Helpers ----------
+// Serialised in one pass with JsonWriter; /bulk answers can run to
+// thousands of rows.
+std::string bulkJson(const BulkResult& r) {
+    JsonWriter w(256 * (r.airports.size() + r.airlines.size() + r.missingAirports.size() +
+                        r.missingAirlines.size()) + 64);
+    w.beginObject().key("airports").beginObject();
+    for (const auto& kv : r.airports) {
+        w.key(kv.first);
+        writeAirportJson(w, kv.second);
+    }
+    w.endObject().key("airlines").beginObject();
+    for (const auto& kv : r.airlines) {
+        w.key(kv.first);
+        writeAirlineJson(w, kv.second);
+    }
+    w.endObject().key("missing").beginObject().key("airports").beginArray();
+    for (const std::string& code : r.missingAirports) w.value(code);
+    w.endArray().key("airlines").beginArray();
+    for (const std::string& code : r.missingAirlines) w.value(code);
+    w.endArray().endObject();
+    size_t found = r.airports.size() + r.airlines.size();
+    w.field("found", static_cast<int>(found))
+        .field("requested", static_cast<int>(found + r.missingAirports.size() + r.missingAirlines.size()))
+        .endObject();
+    return w.take();
+}
 
-std::vector<std::string> parseCsvLine(const std::string& line) {
-    std::vector<std::string> result;
-    std::string field;
-    bool inQuotes = false;
+crow::json::wvalue toJson(const SuggestResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.suggestions.size());
+    for (size_t i = 0; i < r.suggestions.size(); ++i) {
+        const Suggestion& s = r.suggestions[i];
+        arr[i]["kind"]    = s.airport ? "airport" : "airline";
+        arr[i]["iata"]    = s.iata;
+        arr[i]["icao"]    = s.icao;
+        arr[i]["name"]    = s.name;
+        if (s.airport) arr[i]["city"] = s.city;
+        arr[i]["country"] = s.country;
+        arr[i]["id"]      = s.id;
+        arr[i]["routes"]  = s.routes;
+        arr[i]["matched"] = s.matched;
+        arr[i]["fuzzy"]   = s.fuzzy;
+    }
+    crow::json::wvalue out;
+    out["query"] = r.query;
+    out["suggestions"] = std::move(arr);
+    out["count"] = static_cast<int>(r.suggestions.size());
+    return out;
+}
 
-    for (char c : line) {
-        if (c == '"') {
-            inQuotes = !inQuotes;
-        } else if (c == ',' && !inQuotes) {
-            result.push_back(field);
-            field.clear();
+crow::json::wvalue toJson(const AirlinesForAirportResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.airlines.size());
+    for (size_t i = 0; i < r.airlines.size(); ++i) {
+        arr[i]["id"]      = r.airlines[i].id;
+        arr[i]["name"]    = r.airlines[i].name;
+        arr[i]["iata"]    = r.airlines[i].iata;
+        arr[i]["country"] = r.airlines[i].country;
+    }
+    crow::json::wvalue out;
+    out["airport"]  = r.airport;
+    out["airlines"] = std::move(arr);
+    return out;
+}
+
+crow::json::wvalue toJson(const TopDestinationsResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.rows.size());
+    for (size_t i = 0; i < r.rows.size(); ++i) {
+        const AirportCount& row = r.rows[i];
+        if (r.by == "airport") {
+            arr[i]["iata"]    = row.iata;
+            arr[i]["name"]    = row.name;
+            arr[i]["city"]    = row.city;
+            arr[i]["country"] = row.country;
         } else {
-            field.push_back(c);
+            arr[i][r.by] = r.by == "city" ? row.city : row.country;
         }
+        arr[i]["routes"] = row.routes;
     }
-    result.push_back(field);
-    return result;
+    crow::json::wvalue out;
+    out["airline"] = r.airline;
+    out["by"]      = r.by;
+    if (r.by == "city") out["top_cities"] = std::move(arr);
+    else if (r.by == "airport") out["top_airports"] = std::move(arr);
+    else out["top_countries"] = std::move(arr);
+    return out;
 }
 
-bool isNullField(const std::string& s) {
-    return s == "\\N" || s.empty();
+crow::json::wvalue toJson(const DistanceResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue out;
+    out["src"]         = r.src;
+    out["dst"]         = r.dst;
+    out["distance_km"] = r.km;
+    out["distance_mi"] = r.km * 0.621371;
+    return out;
 }
 
-// ---------- Loaders ----------
+crow::json::wvalue toJson(const AirlinesReportResult& r) {
+    crow::json::wvalue arr = crow::json::wvalue::list(r.airlines.size());
+    for (size_t i = 0; i < r.airlines.size(); ++i) {
+        const AirlineRecord& a = r.airlines[i];
+        arr[i]["id"]      = a.id;
+        arr[i]["name"]    = a.name;
+        arr[i]["iata"]    = a.iata;
+        arr[i]["icao"]    = a.icao;
+        arr[i]["country"] = a.country;
+        arr[i]["active"]  = a.active;
+    }
+    crow::json::wvalue out;
+    out["count"] = static_cast<int>(r.airlines.size());
+    out["airlines"] = std::move(arr);
+    return out;
+}
 
-void loadAirlines(const std::string& filename) {
-    std::ifstream in(filename);
-    if (!in) {
-        std::cerr << "Failed to open airlines file: " << filename << "\n";
-        return;
+crow::json::wvalue toJson(const AirportsReportResult& r) {
+    crow::json::wvalue arr = crow::json::wvalue::list(r.airports.size());
+    for (size_t i = 0; i < r.airports.size(); ++i) {
+        const AirportRecord& ap = r.airports[i];
+        arr[i]["id"]        = ap.id;
+        arr[i]["name"]      = ap.name;
+        arr[i]["iata"]      = ap.iata;
+        arr[i]["city"]      = ap.city;
+        arr[i]["country"]   = ap.country;
+        arr[i]["latitude"]  = ap.latitude;
+        arr[i]["longitude"] = ap.longitude;
+        writeAirportTimeFields(arr[i], ap);
+    }
+    crow::json::wvalue out;
+    out["count"] = static_cast<int>(r.airports.size());
+    out["airports"] = std::move(arr);
+    return out;
+}
+
+crow::json::wvalue toJson(const AirlineRoutesReportResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.airports.size());
+    for (size_t i = 0; i < r.airports.size(); ++i) {
+        const AirportCount& row = r.airports[i];
+        arr[i]["iata"]    = row.iata;
+        arr[i]["name"]    = row.name;
+        arr[i]["city"]    = row.city;
+        arr[i]["country"] = row.country;
+        arr[i]["routes"]  = row.routes;
     }
+    crow::json::wvalue out;
+    out["airline"]["id"]      = r.airline.id;
+    out["airline"]["name"]    = r.airline.name;
+    out["airline"]["iata"]    = r.airline.iata;
+    out["airline"]["country"] = r.airline.country;
+    out["airports"] = std::move(arr);
+    out["count"] = static_cast<int>(r.airports.size());
+    out["operatedOnly"] = r.operatedOnly;
+    return out;
+}
 
-    std::string line;
-    while (std::getline(in, line)) {
-        auto fields = parseCsvLine(line);
-        if (fields.size() < 8) continue;
-
-        Airline a;
-        if (!isNullField(fields[0])) a.id = std::stoi(fields[0]);
-        a.name     = fields[1];
-        a.alias    = fields[2];
-        a.iata     = isNullField(fields[3]) ? "" : fields[3];
-        a.icao     = fields[4];
-        a.callsign = fields[5];
-        a.country  = fields[6];
-        a.active   = fields[7];
-
-        if (a.id == -1) continue;
-        airlinesById[a.id] = a;
+crow::json::wvalue toJson(const AirportRoutesReportResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.airlines.size());
+    for (size_t i = 0; i < r.airlines.size(); ++i) {
+        const AirlineCount& row = r.airlines[i];
+        arr[i]["iata"]    = row.iata;
+        arr[i]["name"]    = row.name;
+        arr[i]["country"] = row.country;
+        arr[i]["routes"]  = row.routes;
     }
+    crow::json::wvalue out;
+    out["airport"]["id"]      = r.airport.id;
+    out["airport"]["name"]    = r.airport.name;
+    out["airport"]["iata"]    = r.airport.iata;
+    out["airport"]["city"]    = r.airport.city;
+    out["airport"]["country"] = r.airport.country;
+    out["airlines"] = std::move(arr);
+    out["count"] = static_cast<int>(r.airlines.size());
+    out["operatedOnly"] = r.operatedOnly;
+    return out;
+}
 
-    // build IATA index
-    for (auto& kv : airlinesById) {
-        Airline& a = kv.second;
-        if (!a.iata.empty()) {
-            airlinesByIata[a.iata] = &a;
+crow::json::wvalue toJson(const OneHopResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.connections.size());
+    for (size_t i = 0; i < r.connections.size(); ++i) {
+        const OneHopConnection& c = r.connections[i];
+        arr[i]["hub_iata"] = c.hubIata;
+        arr[i]["hub_name"] = c.hubName;
+        arr[i]["hub_city"] = c.hubCity;
+        arr[i]["leg1_km"]  = c.leg1Km;
+        arr[i]["leg2_km"]  = c.leg2Km;
+        arr[i]["total_km"] = c.totalKm;
+        arr[i]["total_mi"] = c.totalKm * 0.621371;
+    }
+    crow::json::wvalue out;
+    out["src"] = r.src;
+    out["dst"] = r.dst;
+    out["connections"] = std::move(arr);
+    out["count"] = static_cast<int>(r.connections.size());
+    return out;
+}
+
+crow::json::wvalue toJson(const CentralityResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.airports.size());
+    for (size_t i = 0; i < r.airports.size(); ++i) {
+        const CentralityRow& row = r.airports[i];
+        arr[i]["id"] = row.id;
+        if (row.known) {
+            arr[i]["iata"]    = row.iata;
+            arr[i]["name"]    = row.name;
+            arr[i]["city"]    = row.city;
+            arr[i]["country"] = row.country;
         }
+        arr[i]["betweenness"] = row.betweenness;
+        arr[i]["betweenness_normalized"] = row.betweennessNormalized;
+        arr[i]["pagerank"] = row.pagerank;
+    }
+    crow::json::wvalue out;
+    out["by"] = r.byPageRank ? "pagerank" : "betweenness";
+    out["airports"] = std::move(arr);
+    out["count"] = static_cast<int>(r.airports.size());
+    out["compute_ms"] = r.computeMs;
+    out["version"] = r.graphVersion;
+    out["stale"] = r.stale;
+    return out;
+}
+
+crow::json::wvalue toJson(const IsochroneResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.airports.size());
+    for (size_t i = 0; i < r.airports.size(); ++i) {
+        const IsochroneAirport& ap = r.airports[i];
+        arr[i]["iata"]        = ap.iata;
+        arr[i]["name"]        = ap.name;
+        arr[i]["city"]        = ap.city;
+        arr[i]["country"]     = ap.country;
+        arr[i]["latitude"]    = ap.latitude;
+        arr[i]["longitude"]   = ap.longitude;
+        arr[i]["distance_km"] = ap.distanceKm;
+        arr[i]["stops"]       = ap.stops;
+    }
+    crow::json::wvalue out;
+    out["origins"] = r.origins;
+    if (std::isfinite(r.maxKm)) out["max_km"] = r.maxKm;
+    out["max_stops"] = r.maxStops;
+    out["airports"] = std::move(arr);
+    out["count"] = static_cast<int>(r.airports.size());
+    return out;
+}
+
+crow::json::wvalue geoAirportsJson(const std::vector<GeoAirport>& airports) {
+    crow::json::wvalue arr = crow::json::wvalue::list(airports.size());
+    for (size_t i = 0; i < airports.size(); ++i) {
+        const GeoAirport& ap = airports[i];
+        arr[i]["id"]          = ap.id;
+        arr[i]["iata"]        = ap.iata;
+        arr[i]["name"]        = ap.name;
+        arr[i]["city"]        = ap.city;
+        arr[i]["country"]     = ap.country;
+        arr[i]["latitude"]    = ap.latitude;
+        arr[i]["longitude"]   = ap.longitude;
+        arr[i]["distance_km"] = ap.distanceKm;
+    }
+    return arr;
+}
+
+crow::json::wvalue toJson(const NearestResult& r) {
+    crow::json::wvalue out;
+    out["latitude"] = r.latitude;
+    out["longitude"] = r.longitude;
+    out["airports"] = geoAirportsJson(r.airports);
+    out["count"] = static_cast<int>(r.airports.size());
+    return out;
+}
+
+crow::json::wvalue toJson(const WithinResult& r) {
+    crow::json::wvalue out;
+    out["latitude"] = r.latitude;
+    out["longitude"] = r.longitude;
+    out["radius_km"] = r.radiusKm;
+    out["airports"] = geoAirportsJson(r.airports);
+    out["count"] = static_cast<int>(r.airports.size());
+    return out;
+}
+
+crow::json::wvalue toJson(const ComponentResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue out;
+    out["airport"] = r.airport;
+    out["scc"]["id"] = r.scc;
+    out["scc"]["size"] = r.sccSize;
+    out["scc"]["topo_rank"] = r.sccTopoRank;
+    out["wcc"]["id"] = r.wcc;
+    out["wcc"]["size"] = r.wccSize;
+    return out;
+}
+
+crow::json::wvalue toJson(const ReachabilityResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue out;
+    out["src"] = r.src;
+    out["dst"] = r.dst;
+    if (r.reachable < 0) {
+        out["reachable"] = nullptr; // components alone cannot decide
+    } else {
+        out["reachable"] = r.reachable == 1;
+    }
+    return out;
+}
+
+crow::json::wvalue componentSizesJson(const std::vector<ComponentSize>& sizes) {
+    crow::json::wvalue arr = crow::json::wvalue::list(sizes.size());
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        arr[i]["id"] = sizes[i].id;
+        arr[i]["size"] = sizes[i].size;
+    }
+    return arr;
+}
+
+crow::json::wvalue toJson(const ComponentsReportResult& r) {
+    crow::json::wvalue out;
+    out["scc_count"] = r.sccCount;
+    out["largest_scc"] = componentSizesJson(r.largestScc);
+    out["wcc_count"] = r.wccCount;
+    out["largest_wcc"] = componentSizesJson(r.largestWcc);
+    out["airports"] = r.airports;
+    return out;
+}
+
+crow::json::wvalue toJson(const TimezonesReportResult& r) {
+    crow::json::wvalue arr = crow::json::wvalue::list(r.rows.size());
+    for (size_t i = 0; i < r.rows.size(); ++i) {
+        const TimezoneRow& row = r.rows[i];
+        if (!r.byOffset) arr[i]["tz"] = row.tz;
+        arr[i]["utc_offset"] = utcOffsetJson(row.utcOffsetMin);
+        if (!r.byOffset) arr[i]["dst"] = std::string(1, row.dst);
+        arr[i]["airports"] = row.airports;
+    }
+    crow::json::wvalue out;
+    out[r.byOffset ? "offsets" : "timezones"] = std::move(arr);
+    out["count"] = static_cast<int>(r.rows.size());
+    return out;
+}
+
+crow::json::wvalue toJson(const TimezoneAirportsResult& r) {
+    crow::json::wvalue arr = crow::json::wvalue::list(r.airports.size());
+    for (size_t i = 0; i < r.airports.size(); ++i) {
+        const AirportRecord& ap = r.airports[i];
+        arr[i]["id"]        = ap.id;
+        arr[i]["name"]      = ap.name;
+        arr[i]["iata"]      = ap.iata;
+        arr[i]["icao"]      = ap.icao;
+        arr[i]["city"]      = ap.city;
+        arr[i]["country"]   = ap.country;
+        arr[i]["latitude"]  = ap.latitude;
+        arr[i]["longitude"] = ap.longitude;
+        writeAirportTimeFields(arr[i], ap);
     }
+    crow::json::wvalue out;
+    if (r.byOffset) out["utc_offset"] = r.utcOffsetHours;
+    else out["tz"] = r.tz;
+    out["airports"] = std::move(arr);
+    out["count"] = static_cast<int>(r.airports.size());
+    return out;
+}
 
-    std::cerr << "Loaded " << airlinesById.size() << " airlines.\n";
+crow::json::wvalue toJson(const RoutesByEquipmentResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.routes.size());
+    for (size_t i = 0; i < r.routes.size(); ++i) {
+        const RouteRecord& rt = r.routes[i];
+        arr[i]["airline"]   = rt.airline;
+        arr[i]["src"]       = rt.src;
+        arr[i]["dst"]       = rt.dst;
+        arr[i]["stops"]     = rt.stops;
+        arr[i]["codeshare"] = rt.codeshare;
+        arr[i]["equipment"] = rt.equipment;
+    }
+    crow::json::wvalue out;
+    out["equipment"] = r.equipment;
+    out["routes"] = std::move(arr);
+    out["count"] = r.matched;
+    out["returned"] = static_cast<int>(r.routes.size());
+    return out;
 }
 
-void loadAirports(const std::string& filename) {
-    std::ifstream in(filename);
-    if (!in) {
-        std::cerr << "Failed to open airports file: " << filename << "\n";
+crow::json::wvalue toJson(const EquipmentReportResult& r) {
+    crow::json::wvalue arr = crow::json::wvalue::list(r.equipment.size());
+    for (size_t i = 0; i < r.equipment.size(); ++i) {
+        arr[i]["equipment"] = r.equipment[i].equipment;
+        arr[i]["routes"]    = r.equipment[i].routes;
+    }
+    crow::json::wvalue out;
+    out["equipment"] = std::move(arr);
+    out["count"] = r.codes;
+    return out;
+}
+
+crow::json::wvalue toJson(const FleetMixResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.fleet.size());
+    for (size_t i = 0; i < r.fleet.size(); ++i) {
+        arr[i]["equipment"] = r.fleet[i].equipment;
+        arr[i]["routes"]    = r.fleet[i].routes;
+        arr[i]["share"]     = r.fleet[i].share;
+    }
+    crow::json::wvalue out;
+    out["airline"] = r.airline;
+    out["routes"] = r.routes;
+    out["fleet"] = std::move(arr);
+    return out;
+}
+
+void writeHopRow(crow::json::wvalue& out, const HopRow& h) {
+    if (!h.hasCodes) {
+        out["error"] = h.error;
+        return;
+    }
+    out["src"] = h.src;
+    out["dst"] = h.dst;
+    if (!h.error.empty()) {
+        out["error"] = h.error;
         return;
     }
 
-    std::string line;
-    while (std::getline(in, line)) {
-        auto fields = parseCsvLine(line);
-        if (fields.size() < 8) continue;
-
-        Airport ap;
-        if (!isNullField(fields[0])) ap.id = std::stoi(fields[0]);
-        ap.name     = fields[1];
-        ap.city     = fields[2];
-        ap.country  = fields[3];
-        ap.iata     = isNullField(fields[4]) ? "" : fields[4];
-        ap.icao     = fields[5];
-        ap.latitude  = isNullField(fields[6]) ? 0.0 : std::stod(fields[6]);
-        ap.longitude = isNullField(fields[7]) ? 0.0 : std::stod(fields[7]);
-
-        if (ap.id == -1) continue;
-        airportsById[ap.id] = ap;
+    out["reachable"] = h.hops >= 0;
+    if (h.hops < 0) {
+        out["hops"] = nullptr;
+        out["stops"] = nullptr;
+    } else {
+        out["hops"] = h.hops;
+        out["stops"] = h.hops > 0 ? h.hops - 1 : 0;
+        if (h.saturated) out["saturated"] = true;
+    }
+    if (h.maxStops >= 0) {
+        out["max_stops"] = h.maxStops;
+        if (h.withinMaxStops < 0) out["within_max_stops"] = nullptr;
+        else out["within_max_stops"] = h.withinMaxStops == 1;
     }
+}
+
+crow::json::wvalue toJson(const HopsResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue out;
+    writeHopRow(out, r.hop);
+    out["version"] = r.graphVersion;
+    out["stale"] = r.stale;
+    return out;
+}
+
+crow::json::wvalue toJson(const HopsBulkResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue arr = crow::json::wvalue::list(r.results.size());
+    for (size_t i = 0; i < r.results.size(); ++i) writeHopRow(arr[i], r.results[i]);
+    crow::json::wvalue out;
+    out["results"] = std::move(arr);
+    out["count"] = static_cast<int>(r.results.size());
+    out["version"] = r.graphVersion;
+    out["stale"] = r.stale;
+    return out;
+}
+
+crow::json::wvalue toJson(const MutationResult& r) {
+    if (!r.ok()) return errorJson(r.error);
+    crow::json::wvalue out;
+    out["success"] = true;
+    out["message"] = r.message;
+    if (r.hasId) out["id"] = r.id;
+    return out;
+}
+
+// ---------- Body Parsing ----------
+
+// Mutation bodies to engine field sets. A member of the wrong type throws and
+// Crow answers 500.
+
+void readString(const crow::json::rvalue& body, const char* name, std::optional<std::string>& out) {
+    if (body.has(name)) out = std::string(body[name].s());
+}
+
+AirlineFields airlineFields(const crow::json::rvalue& body) {
+    AirlineFields f;
+    readString(body, "name", f.name);
+    readString(body, "alias", f.alias);
+    readString(body, "iata", f.iata);
+    readString(body, "icao", f.icao);
+    readString(body, "callsign", f.callsign);
+    readString(body, "country", f.country);
+    readString(body, "active", f.active);
+    return f;
+}
 
-    // build IATA index
-    for (auto& kv : airportsById) {
-        Airport& ap = kv.second;
-        if (!ap.iata.empty()) {
-            airportsByIata[ap.iata] = &ap;
+// Includes the optional airports.dat columns 9-14.
+AirportFields airportFields(const crow::json::rvalue& body) {
+    AirportFields f;
+    readString(body, "name", f.name);
+    readString(body, "city", f.city);
+    readString(body, "country", f.country);
+    readString(body, "iata", f.iata);
+    readString(body, "icao", f.icao);
+    if (body.has("latitude")) f.latitude = body["latitude"].d();
+    if (body.has("longitude")) f.longitude = body["longitude"].d();
+    if (body.has("altitude_ft")) f.altitudeFt = static_cast<int16_t>(body["altitude_ft"].i());
+    if (body.has("utc_offset")) {
+        f.utcOffsetMin = body["utc_offset"].t() == crow::json::type::Null
+                             ? UTC_OFFSET_UNKNOWN
+                             : static_cast<int16_t>(std::lround(body["utc_offset"].d() * 60.0));
+    }
+    if (body.has("dst")) {
+        std::string dst = std::string(body["dst"].s());
+        f.dst = dst.empty() ? 'U' : dst[0];
+    }
+    readString(body, "tz", f.tz);
+    readString(body, "type", f.type);
+    readString(body, "source", f.source);
+    return f;
+}
+
+// ---------- Result Cache ----------
+
+// Sharded, byte-bounded LRU of serialized JSON bodies. Keys embed the dataset
+// version, so a mutation invalidates everything implicitly: old entries are
+// never hit again and age out of the LRU.
+class ResultCache {
+public:
+    static const size_t SHARDS = 16;
+
+    explicit ResultCache(size_t capacityBytes) : shardCapacity_(capacityBytes / SHARDS) {}
+
+    bool enabled() const { return shardCapacity_ > 0; }
+
+    std::shared_ptr<const std::string> get(const std::string& key) {
+        Shard& sh = shardFor(key);
+        std::lock_guard<std::mutex> lk(sh.mutex);
+        auto it = sh.index.find(key);
+        if (it == sh.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
         }
+        sh.lru.splice(sh.lru.begin(), sh.lru, it->second);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return it->second->value;
     }
 
-    std::cerr << "Loaded " << airportsById.size() << " airports.\n";
+    void put(const std::string& key, std::shared_ptr<const std::string> value) {
+        size_t cost = entryCost(key, *value);
+        if (cost > shardCapacity_) return;
+
+        Shard& sh = shardFor(key);
+        std::lock_guard<std::mutex> lk(sh.mutex);
+        auto it = sh.index.find(key);
+        if (it != sh.index.end()) {
+            sh.bytes -= entryCost(key, *it->second->value);
+            sh.lru.erase(it->second);
+            sh.index.erase(it);
+        }
+        sh.lru.push_front({ key, std::move(value) });
+        sh.index[key] = sh.lru.begin();
+        sh.bytes += cost;
+
+        while (sh.bytes > shardCapacity_) {
+            const Entry& victim = sh.lru.back();
+            sh.bytes -= entryCost(victim.key, *victim.value);
+            sh.index.erase(victim.key);
+            sh.lru.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    crow::json::wvalue stats() {
+        size_t entries = 0, bytes = 0;
+        for (auto& sh : shards_) {
+            std::lock_guard<std::mutex> lk(sh.mutex);
+            entries += sh.index.size();
+            bytes += sh.bytes;
+        }
+        crow::json::wvalue r;
+        r["hits"]           = hits_.load();
+        r["misses"]         = misses_.load();
+        r["evictions"]      = evictions_.load();
+        r["entries"]        = entries;
+        r["bytes"]          = bytes;
+        r["capacity_bytes"] = shardCapacity_ * SHARDS;
+        return r;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const std::string> value;
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    static size_t entryCost(const std::string& key, const std::string& value) {
+        return key.size() * 2 + value.size() + 64; // key stored twice + bookkeeping
+    }
+
+    Shard& shardFor(const std::string& key) {
+        return shards_[std::hash<std::string>()(key) % SHARDS];
+    }
+
+    size_t shardCapacity_;
+    Shard shards_[SHARDS];
+    std::atomic<uint64_t> hits_{0}, misses_{0}, evictions_{0};
+};
+
+ResultCache& resultCache() {
+    static ResultCache cache([](){
+        const char* env = std::getenv("RESULT_CACHE_MB");
+        long mb = env ? std::atol(env) : 64;
+        return static_cast<size_t>(mb > 0 ? mb : 0) * 1024 * 1024;
+    }());
+    return cache;
 }
 
-void loadRoutes(const std::string& filename) {
-    std::ifstream in(filename);
-    if (!in) {
-        std::cerr << "Failed to open routes file: " << filename << "\n";
-        return;
+// ---------- Request Coalescing ----------
+
+// Single-flight: concurrent callers with the same key wait on one in-progress
+// computation and share its serialized body instead of each computing it.
+class SingleFlight {
+public:
+    using Body = std::shared_ptr<const std::string>;
+
+    Body run(const std::string& key, const std::function<Body()>& fn, bool& joined) {
+        std::shared_ptr<std::promise<Body>> promise;
+        std::shared_future<Body> pending;
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            auto it = inFlight_.find(key);
+            if (it != inFlight_.end()) {
+                pending = it->second;
+            } else {
+                promise = std::make_shared<std::promise<Body>>();
+                inFlight_[key] = promise->get_future().share();
+            }
+        }
+
+        if (!promise) {
+            joined = true;
+            shared_.fetch_add(1, std::memory_order_relaxed);
+            return pending.get();
+        }
+
+        joined = false;
+        computations_.fetch_add(1, std::memory_order_relaxed);
+        Body body;
+        try {
+            body = fn();
+        } catch (...) {
+            finish(key);
+            promise->set_exception(std::current_exception());
+            throw;
+        }
+        finish(key);
+        promise->set_value(body);
+        return body;
+    }
+
+    crow::json::wvalue stats() const {
+        crow::json::wvalue r;
+        r["computations"] = computations_.load();
+        r["shared"]       = shared_.load();
+        return r;
+    }
+
+private:
+    void finish(const std::string& key) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        inFlight_.erase(key);
     }
 
-    std::string line;
-    while (std::getline(in, line)) {
-        if (line.empty()) continue;
-        auto fields = parseCsvLine(line);
-        if (fields.size() < 8) continue;
-
-        Route r;
-        // fields: 0 airline code, 1 airline ID,
-        //         2 src code,   3 src ID,
-        //         4 dst code,   5 dst ID,
-        //         6 codeshare,  7 stops, ...
-        if (!isNullField(fields[1])) r.airlineId    = std::stoi(fields[1]);
-        if (!isNullField(fields[3])) r.srcAirportId = std::stoi(fields[3]);
-        if (!isNullField(fields[5])) r.dstAirportId = std::stoi(fields[5]);
-        if (!isNullField(fields[7])) r.stops        = std::stoi(fields[7]);
-
-        if (r.airlineId == -1 || r.srcAirportId == -1 || r.dstAirportId == -1)
-            continue;
-
-        routes.push_back(r);
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_future<Body>> inFlight_;
+    std::atomic<uint64_t> computations_{0}, shared_{0};
+};
+
+SingleFlight& singleFlight() {
+    static SingleFlight flights;
+    return flights;
+}
+
+crow::response jsonResponse(const std::string& body) {
+    crow::response res(200);
+    res.set_header("Content-Type", "application/json");
+    res.body = body;
+    return res;
+}
+
+std::string versionedKey(const std::string& key, uint64_t version) {
+    return key + "@" + std::to_string(version);
+}
+
+// Runs query and serializes its result; the body's version is the one the
+// engine computed against.
+template <typename Query>
+std::shared_ptr<const std::string> computeJson(Query& query, uint64_t& version) {
+    TraceSpan span("handler.compute");
+    auto result = query();
+    span.phase("json.serialize");
+    version = result.version;
+    return std::make_shared<const std::string>(toJson(result).dump());
+}
+
+// Computes key once for all concurrent identical requests.
+template <typename Query>
+crow::response singleFlightJson(const std::string& key, Query query) {
+    bool joined = false;
+    auto body = singleFlight().run(versionedKey(key, datasetVersion.load()), [&query] {
+        uint64_t version = 0;
+        return computeJson(query, version);
+    }, joined);
+    crow::response res = jsonResponse(*body);
+    if (joined) res.set_header("X-Cache", "SHARED");
+    return res;
+}
+
+// Serves key from the cache, or computes it (coalesced with identical
+// in-flight requests) and stores it under the version the engine reports,
+// so a mutation racing the computation cannot file a new body under an old
+// version.
+template <typename Query>
+crow::response cachedJson(const std::string& key, Query query) {
+    ResultCache& cache = resultCache();
+    if (!cache.enabled()) return singleFlightJson(key, std::move(query));
+
+    std::string fullKey = versionedKey(key, datasetVersion.load());
+    TraceSpan lookup("cache.lookup");
+    if (auto hit = cache.get(fullKey)) {
+        crow::response res = jsonResponse(*hit);
+        res.set_header("X-Cache", "HIT");
+        return res;
     }
+    lookup.end();
+
+    bool joined = false;
+    auto body = singleFlight().run(fullKey, [&] {
+        uint64_t version = 0;
+        auto computed = computeJson(query, version);
+        TraceSpan span("cache.store");
+        cache.put(versionedKey(key, version), computed);
+        return computed;
+    }, joined);
+    crow::response res = jsonResponse(*body);
+    res.set_header("X-Cache", joined ? "SHARED" : "MISS");
+    return res;
+}
 
-    std::cerr << "Loaded " << routes.size() << " routes.\n";
+// ---------- Request Helpers ----------
+
+// ?operatedOnly=true|1 drops codeshare (marketed-only) routes from counts
+bool operatedOnlyParam(const crow::request& req) {
+    const char* v = req.url_params.get("operatedOnly");
+    return v && (std::string(v) == "true" || std::string(v) == "1");
 }
 
-// ---------- Lookup Helpers ----------
+// Whole-string numeric parse; false for missing, partial, NaN or infinite input.
+bool parseDoubleParam(const char* text, double& out) {
+    if (!text || !*text) return false;
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtod(text, &end);
+    return errno == 0 && *end == '\0' && std::isfinite(out);
+}
 
-Airline* getAirlineByIata(const std::string& code) {
-    auto it = airlinesByIata.find(code);
-    if (it == airlinesByIata.end()) return nullptr;
-    return it->second;
+// Whole-string integer parse; false for missing, partial or out-of-range input.
+bool parseIntParam(const char* text, int& out) {
+    if (!text || !*text) return false;
+    char* end = nullptr;
+    errno = 0;
+    long v = std::strtol(text, &end, 10);
+    if (errno != 0 || *end != '\0' || v < std::numeric_limits<int>::min() || v > std::numeric_limits<int>::max()) {
+        return false;
+    }
+    out = static_cast<int>(v);
+    return true;
 }
 
-Airport* getAirportByIata(const std::string& code) {
-    auto it = airportsByIata.find(code);
-    if (it == airportsByIata.end()) return nullptr;
-    return it->second;
+// lat in [-90, 90] and lon in [-180, 180]; on failure error says why.
+bool parseLatLonParams(const crow::request& req, double& lat, double& lon, crow::json::wvalue& error) {
+    const char* latParam = req.url_params.get("lat");
+    const char* lonParam = req.url_params.get("lon");
+    if (!latParam || !lonParam) {
+        error["error"] = "lat and lon are required";
+        return false;
+    }
+    if (!parseDoubleParam(latParam, lat) || lat < -90.0 || lat > 90.0) {
+        error["error"] = "lat must be a number in [-90, 90]";
+        return false;
+    }
+    if (!parseDoubleParam(lonParam, lon) || lon < -180.0 || lon > 180.0) {
+        error["error"] = "lon must be a number in [-180, 180]";
+        return false;
+    }
+    return true;
 }
 
-// Haversine distance in kilometers
-double haversineKm(double lat1, double lon1, double lat2, double lon2) {
-    const double R = 6371.0; // Earth radius in km
-    double dLat = (lat2 - lat1) * PI / 180.0;
-    double dLon = (lon2 - lon1) * PI / 180.0;
-    double a =
-        std::sin(dLat / 2) * std::sin(dLat / 2) +
-        std::cos(lat1 * PI / 180.0) * std::cos(lat2 * PI / 180.0) *
-        std::sin(dLon / 2) * std::sin(dLon / 2);
-    double c = 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
-    return R * c;
+crow::json::wvalue invalidJson() {
+    crow::json::wvalue r;
+    r["error"] = "Invalid JSON";
+    return r;
 }
 
 // ---------- CORS Helpers ----------
@@ -244,6 +938,400 @@ struct CorsMiddleware {
     }
 };
 
+// ---------- Metrics ----------
+
+// Route templates used as metric labels, so series stay bounded no matter
+// which codes are requested. Keep in step with the CROW_ROUTE registrations;
+// specific templates come before ones they overlap. Unmatched paths count as
+// "other".
+const char* const METRIC_ROUTES[] = {
+    "/health", "/student", "/metrics", "/code", "/bulk", "/suggest", "/nearest", "/within",
+    "/airline", "/airline/icao/<code>", "/airline/<code>",
+    "/airport", "/airport/icao/<code>", "/airport/<code>",
+    "/airports/timezone", "/airlinesForAirport/<code>", "/topCitiesForAirline/<code>",
+    "/distance/<src>/<dst>", "/onehop/<src>/<dst>", "/isochrone/<origins>",
+    "/reports/airlines", "/reports/airports", "/reports/airlineRoutes/<code>",
+    "/reports/airportRoutes/<code>", "/reports/centrality", "/reports/components",
+    "/reports/timezones", "/reports/equipment", "/reports/fleetMix/<code>",
+    "/routes/equipment/<code>", "/components/<code>", "/components/<src>/<dst>",
+    "/hops", "/hops/<src>/<dst>", "/route", "/cache/stats", "/admin/tracing", "/admin/trace",
+    "/admin/slowlog", "/admin/reload",
+};
+const size_t METRIC_ROUTE_COUNT = sizeof(METRIC_ROUTES) / sizeof(METRIC_ROUTES[0]);
+const size_t METRIC_LABELS = METRIC_ROUTE_COUNT + 1;   // + "other"
+
+const char* const METRIC_METHODS[] = { "GET", "POST", "PUT", "DELETE", "OPTIONS", "OTHER" };
+const size_t METRIC_METHOD_COUNT = 6;
+
+// Latency buckets are powers of two in microseconds: 16us, 32us, ... ~16.8s.
+const int METRIC_BUCKET_MIN_LOG2 = 4;
+const size_t METRIC_BUCKETS = 21;   // plus one overflow (+Inf) bucket
+
+std::vector<std::string_view> splitPath(std::string_view path) {
+    std::vector<std::string_view> parts;
+    size_t pos = 0;
+    while (pos < path.size()) {
+        size_t end = path.find('/', pos);
+        if (end == std::string_view::npos) end = path.size();
+        if (end > pos) parts.push_back(path.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return parts;
+}
+
+size_t metricRouteIndex(std::string_view path) {
+    static const std::vector<std::vector<std::string_view>> templates = [] {
+        std::vector<std::vector<std::string_view>> t;
+        for (const char* route : METRIC_ROUTES) t.push_back(splitPath(route));
+        return t;
+    }();
+    std::vector<std::string_view> parts = splitPath(path);
+    for (size_t i = 0; i < templates.size(); ++i) {
+        const auto& tpl = templates[i];
+        if (tpl.size() != parts.size()) continue;
+        bool match = true;
+        for (size_t j = 0; j < tpl.size() && match; ++j) {
+            match = tpl[j].front() == '<' || tpl[j] == parts[j];
+        }
+        if (match) return i;
+    }
+    return METRIC_ROUTE_COUNT;
+}
+
+size_t metricMethodIndex(crow::HTTPMethod m) {
+    switch (m) {
+        case crow::HTTPMethod::Get: return 0;
+        case crow::HTTPMethod::Post: return 1;
+        case crow::HTTPMethod::Put: return 2;
+        case crow::HTTPMethod::Delete: return 3;
+        case crow::HTTPMethod::Options: return 4;
+        default: return 5;
+    }
+}
+
+size_t metricBucketIndex(uint64_t micros) {
+    if (micros <= (uint64_t(1) << METRIC_BUCKET_MIN_LOG2)) return 0;
+    size_t bits = 64 - static_cast<size_t>(__builtin_clzll(micros - 1));   // ceil(log2)
+    return std::min(bits - METRIC_BUCKET_MIN_LOG2, METRIC_BUCKETS);
+}
+
+// Counters for one worker thread. Only the owning thread writes (plain
+// load + store, no locked instructions); /metrics sums all shards.
+struct MetricsShard {
+    struct Series {
+        std::atomic<uint64_t> status[5];                    // 1xx .. 5xx
+        std::atomic<uint64_t> buckets[METRIC_BUCKETS + 1];
+        std::atomic<uint64_t> sumMicros;
+    };
+
+    std::unique_ptr<Series[]> series{ new Series[METRIC_LABELS * METRIC_METHOD_COUNT]() };
+
+    static void bump(std::atomic<uint64_t>& c, uint64_t by = 1) {
+        c.store(c.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    // timed = false for requests Crow answers without running before_handle
+    // (e.g. automatic OPTIONS replies); they are counted but not timed.
+    void record(size_t route, size_t method, int status, bool timed, uint64_t micros) {
+        Series& s = series[route * METRIC_METHOD_COUNT + method];
+        int cls = std::min(std::max(status / 100, 1), 5) - 1;
+        bump(s.status[cls]);
+        if (!timed) return;
+        bump(s.buckets[metricBucketIndex(micros)]);
+        bump(s.sumMicros, micros);
+    }
+};
+
+std::mutex metricsShardsMutex;
+std::vector<std::unique_ptr<MetricsShard>> metricsShards;
+
+MetricsShard& localMetricsShard() {
+    thread_local MetricsShard* shard = [] {
+        std::lock_guard<std::mutex> lock(metricsShardsMutex);
+        metricsShards.push_back(std::make_unique<MetricsShard>());
+        return metricsShards.back().get();
+    }();
+    return *shard;
+}
+
+// Prometheus text exposition of the request counters and latency histograms.
+std::string renderMetrics() {
+    const size_t n = METRIC_LABELS * METRIC_METHOD_COUNT;
+    std::vector<std::array<uint64_t, 5>> status(n, std::array<uint64_t, 5>{});
+    std::vector<std::array<uint64_t, METRIC_BUCKETS + 1>> buckets(n, std::array<uint64_t, METRIC_BUCKETS + 1>{});
+    std::vector<uint64_t> sums(n, 0);
+    {
+        std::lock_guard<std::mutex> lock(metricsShardsMutex);
+        for (const auto& shard : metricsShards) {
+            for (size_t i = 0; i < n; ++i) {
+                const MetricsShard::Series& s = shard->series[i];
+                for (size_t c = 0; c < 5; ++c) status[i][c] += s.status[c].load(std::memory_order_relaxed);
+                for (size_t b = 0; b <= METRIC_BUCKETS; ++b) buckets[i][b] += s.buckets[b].load(std::memory_order_relaxed);
+                sums[i] += s.sumMicros.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    auto labels = [](size_t i) {
+        size_t route = i / METRIC_METHOD_COUNT;
+        std::string out = "route=\"";
+        out += route < METRIC_ROUTE_COUNT ? METRIC_ROUTES[route] : "other";
+        out += "\",method=\"";
+        out += METRIC_METHODS[i % METRIC_METHOD_COUNT];
+        out += '"';
+        return out;
+    };
+    auto seconds = [](double micros) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.9g", micros / 1e6);
+        return std::string(buf);
+    };
+
+    std::string out;
+    out += "# HELP http_requests_total Requests handled, by route template, method and status class.\n";
+    out += "# TYPE http_requests_total counter\n";
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t c = 0; c < 5; ++c) {
+            if (status[i][c] == 0) continue;
+            out += "http_requests_total{" + labels(i) + ",status=\"" + std::to_string(c + 1) + "xx\"} " +
+                   std::to_string(status[i][c]) + "\n";
+        }
+    }
+
+    out += "# HELP http_request_duration_seconds Time from middleware entry to response, by route template and method.\n";
+    out += "# TYPE http_request_duration_seconds histogram\n";
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t total = 0;
+        for (uint64_t c : buckets[i]) total += c;
+        if (total == 0) continue;
+        std::string l = labels(i);
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < METRIC_BUCKETS; ++b) {
+            cumulative += buckets[i][b];
+            double bound = static_cast<double>(uint64_t(1) << (METRIC_BUCKET_MIN_LOG2 + b));
+            out += "http_request_duration_seconds_bucket{" + l + ",le=\"" + seconds(bound) + "\"} " +
+                   std::to_string(cumulative) + "\n";
+        }
+        out += "http_request_duration_seconds_bucket{" + l + ",le=\"+Inf\"} " + std::to_string(total) + "\n";
+        out += "http_request_duration_seconds_sum{" + l + "} " + seconds(static_cast<double>(sums[i])) + "\n";
+        out += "http_request_duration_seconds_count{" + l + "} " + std::to_string(total) + "\n";
+    }
+
+    out += "# HELP dataset_version Monotonic version of the in-memory dataset.\n";
+    out += "# TYPE dataset_version gauge\n";
+    out += "dataset_version " + std::to_string(datasetVersion.load()) + "\n";
+    return out;
+}
+
+// ---------- Slow Query Log ----------
+
+// Requests slower than the threshold (SLOW_QUERY_MS, 0 = off) are handed to a
+// background writer through a bounded queue. Workers only append under a
+// short lock and drop (and count) entries when the queue is full, so logging
+// never waits on I/O. Lines are JSON, appended to SLOW_QUERY_LOG or stderr;
+// the newest are also kept for /admin/slowlog.
+struct SlowQuery {
+    uint64_t unixMs = 0;
+    size_t route = 0;              // METRIC_ROUTES index
+    size_t method = 0;             // METRIC_METHODS index
+    std::string path;
+    std::string query;             // raw query string
+    size_t bodyBytes = 0;
+    int status = 0;
+    uint64_t micros = 0;
+    uint64_t version = 0;
+    uint64_t routesScanned = 0;
+    std::vector<RequestProfile::Phase> phases;
+};
+
+class SlowQueryLog {
+public:
+    static const size_t QUEUE_CAPACITY = 1024;
+    static const size_t RECENT_ENTRIES = 100;
+
+    bool enabled() const { return thresholdUs_.load(std::memory_order_relaxed) > 0; }
+    uint64_t thresholdUs() const { return thresholdUs_.load(std::memory_order_relaxed); }
+    void setThresholdMs(double ms) { thresholdUs_.store(ms > 0 ? static_cast<uint64_t>(ms * 1000.0) : 0); }
+
+    // Starts the writer thread once; the file is opened in append mode.
+    void start(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (started_) return;
+        started_ = true;
+        if (!path.empty()) {
+            file_.open(path, std::ios::app);
+            if (!file_) std::cerr << "Failed to open slow query log: " << path << "\n";
+        }
+        std::thread([this] { run(); }).detach();
+    }
+
+    void submit(SlowQuery&& q) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!started_ || queue_.size() >= QUEUE_CAPACITY) {
+                dropped_ += 1;
+                return;
+            }
+            queue_.push_back(std::move(q));
+        }
+        cv_.notify_one();
+    }
+
+    std::string recentJson() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        JsonWriter w(256 + recent_.size() * 512);
+        w.beginObject();
+        w.key("threshold_ms").fixed(thresholdUs() / 1000.0, 3);
+        w.field("logged", logged_).field("dropped", dropped_).key("recent").beginArray();
+        for (const std::string& line : recent_) w.raw(line);
+        w.endArray().endObject();
+        return w.take();
+    }
+
+private:
+    void run() {
+        std::vector<SlowQuery> batch;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return !queue_.empty(); });
+                batch.swap(queue_);
+            }
+            std::vector<std::string> lines;
+            lines.reserve(batch.size());
+            for (const SlowQuery& q : batch) lines.push_back(format(q));
+            batch.clear();
+
+            std::ostream& out = file_.is_open() ? static_cast<std::ostream&>(file_) : std::cerr;
+            for (const std::string& line : lines) out << line << '\n';
+            out.flush();
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (std::string& line : lines) {
+                recent_.push_back(std::move(line));
+                if (recent_.size() > RECENT_ENTRIES) recent_.pop_front();
+                logged_ += 1;
+            }
+        }
+    }
+
+    static std::string format(const SlowQuery& q) {
+        JsonWriter w(512);
+        w.beginObject();
+        w.key("ts").fixed(q.unixMs / 1000.0, 3);
+        w
+            .field("route", q.route < METRIC_ROUTE_COUNT ? METRIC_ROUTES[q.route] : "other")
+            .field("method", METRIC_METHODS[q.method])
+            .field("path", q.path);
+
+        // path parameters named by the route template, then the query string
+        w.key("params").beginObject();
+        if (q.route < METRIC_ROUTE_COUNT) {
+            std::vector<std::string_view> tpl = splitPath(METRIC_ROUTES[q.route]);
+            std::vector<std::string_view> parts = splitPath(q.path);
+            for (size_t i = 0; i < tpl.size() && i < parts.size(); ++i) {
+                if (tpl[i].front() == '<') w.field(tpl[i].substr(1, tpl[i].size() - 2), parts[i]);
+            }
+        }
+        std::string_view query = q.query;
+        while (!query.empty()) {
+            size_t amp = query.find('&');
+            std::string_view pair = query.substr(0, amp);
+            size_t eq = pair.find('=');
+            if (!pair.empty()) {
+                w.field(pair.substr(0, eq), eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1));
+            }
+            if (amp == std::string_view::npos) break;
+            query.remove_prefix(amp + 1);
+        }
+        w.endObject();
+
+        if (q.bodyBytes > 0) w.field("body_bytes", static_cast<uint64_t>(q.bodyBytes));
+        w.field("status", q.status);
+        w.key("ms").fixed(q.micros / 1000.0, 3);
+        w.field("version", q.version)
+            .field("routes_scanned", q.routesScanned);
+        w.key("phases").beginArray();
+        for (const auto& p : q.phases) {
+            w.beginObject().field("name", p.name);
+            w.key("ms").fixed(p.durNs / 1e6, 3);
+            w.endObject();
+        }
+        w.endArray().endObject();
+        return w.take();
+    }
+
+    std::atomic<uint64_t> thresholdUs_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<SlowQuery> queue_;
+    std::deque<std::string> recent_;
+    std::ofstream file_;
+    uint64_t logged_ = 0;
+    uint64_t dropped_ = 0;
+    bool started_ = false;
+};
+
+// Never destroyed: the detached writer thread may still be waiting on it
+// when static destructors run at exit.
+SlowQueryLog& slowQueryLog() {
+    static SlowQueryLog* log = new SlowQueryLog;
+    return *log;
+}
+
+// ---------- Metrics Middleware ----------
+
+// Feeds the per-route metrics, the whole-request trace span and the slow
+// query log; runs next to CorsMiddleware.
+struct MetricsMiddleware {
+    struct context {
+        std::chrono::steady_clock::time_point start{};   // epoch = not set
+    };
+
+    void before_handle(crow::request& /*req*/, crow::response& /*res*/, context& ctx) {
+        if (slowQueryLog().enabled()) requestProfile.begin();
+        ctx.start = std::chrono::steady_clock::now();
+    }
+
+    void after_handle(crow::request& req, crow::response& res, context& ctx) {
+        bool timed = ctx.start.time_since_epoch().count() != 0;
+        auto micros = timed ? std::chrono::duration_cast<std::chrono::microseconds>(
+                                  std::chrono::steady_clock::now() - ctx.start).count()
+                            : 0;
+        size_t route = metricRouteIndex(req.url);
+        localMetricsShard().record(route, metricMethodIndex(req.method), res.code, timed,
+                                   static_cast<uint64_t>(micros));
+
+        // whole-request span, named by route template
+        if (timed && tracingEnabled.load(std::memory_order_relaxed)) {
+            auto startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(ctx.start - traceOrigin).count();
+            recordTraceEvent(route < METRIC_ROUTE_COUNT ? METRIC_ROUTES[route] : "other",
+                             static_cast<uint64_t>(std::max<int64_t>(startNs, 0)), traceNowNs());
+        }
+
+        if (!requestProfile.active) return;
+        requestProfile.active = false;
+        SlowQueryLog& log = slowQueryLog();
+        if (!timed || static_cast<uint64_t>(micros) < log.thresholdUs()) return;
+
+        SlowQuery q;
+        q.unixMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        q.route = route;
+        q.method = metricMethodIndex(req.method);
+        q.path = req.url;
+        size_t qmark = req.raw_url.find('?');
+        if (qmark != std::string::npos) q.query = req.raw_url.substr(qmark + 1);
+        q.bodyBytes = req.body.size();
+        q.status = res.code;
+        q.micros = static_cast<uint64_t>(micros);
+        q.version = datasetVersion.load();
+        q.routesScanned = requestProfile.routesScanned;
+        q.phases.assign(requestProfile.phases, requestProfile.phases + requestProfile.phaseCount);
+        log.submit(std::move(q));
+    }
+};
+
 // ---------- WinMain shim (for some MinGW setups) ----------
 
 #ifdef _WIN32
@@ -257,12 +1345,35 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 // ---------- MAIN ----------
 
 int main() {
-    loadAirlines("airlines.dat");
-    loadAirports("airports.dat");
-    loadRoutes("routes.dat");
+    // opt-in: hop matrix and centrality are recomputed in full, in the
+    // background, after every dataset change (ANALYTICS_THREADS workers)
+    EngineOptions options;
+    options.graphAirportsOnly = envEnabled("GRAPH_AIRPORTS_ONLY", false);
+    options.hopMatrix = envEnabled("PRECOMPUTE_HOPS", false);
+    options.centrality = envEnabled("PRECOMPUTE_CENTRALITY", false);
+    if (const char* threads = std::getenv("ANALYTICS_THREADS")) {
+        options.analyticsThreads = static_cast<unsigned>(std::max(std::atoi(threads), 0));
+    }
+    setEngineOptions(options);
+
+    const char* dataDirEnv = std::getenv("DATA_DIR");
+    const std::string dataDir = dataDirEnv ? dataDirEnv : ".";
+    loadDataset(dataDir);
+    // reload when the .dat files are rewritten (Linux only)
+    if (envEnabled("WATCH_DATA", false) && !watchDataset(dataDir)) {
+        std::cerr << "WATCH_DATA: cannot watch " << dataDir << "\n";
+    }
 
-    // use CORS middleware
-    crow::App<CorsMiddleware> app;
+    tracingEnabled = envEnabled("TRACING", false);
+    if (const char* slowMs = std::getenv("SLOW_QUERY_MS")) slowQueryLog().setThresholdMs(std::atof(slowMs));
+    {
+        const char* slowPath = std::getenv("SLOW_QUERY_LOG");
+        slowQueryLog().start(slowPath ? slowPath : "");
+    }
+    std::thread analytics(analyticsWorker);
+
+    // CORS headers and per-route request metrics
+    crow::App<CorsMiddleware, MetricsMiddleware> app;
 
     // --- basic health check ---
     CROW_ROUTE(app, "/health")
@@ -284,729 +1395,508 @@ int main() {
     // --- airline by IATA ---
     CROW_ROUTE(app, "/airline/<string>")
     ([](const std::string& iata) {
-        crow::json::wvalue r;
-        Airline* a = getAirlineByIata(iata);
-        if (!a) {
-            r["error"] = "Airline not found";
-            return r;
-        }
-        r["id"]       = a->id;
-        r["name"]     = a->name;
-        r["alias"]    = a->alias;
-        r["iata"]     = a->iata;
-        r["icao"]     = a->icao;
-        r["callsign"] = a->callsign;
-        r["country"]  = a->country;
-        r["active"]   = a->active;
-        return r;
+        return toJson(queryAirline(iata));
+    });
+
+    // --- airline by ICAO (3 characters) ---
+    CROW_ROUTE(app, "/airline/icao/<string>")
+    ([](const std::string& icao) {
+        return toJson(queryAirlineByIcao(icao));
     });
 
     // --- airport by IATA ---
     CROW_ROUTE(app, "/airport/<string>")
     ([](const std::string& iata) {
-        crow::json::wvalue r;
-        Airport* ap = getAirportByIata(iata);
-        if (!ap) {
-            r["error"] = "Airport not found";
-            return r;
-        }
-        r["id"]        = ap->id;
-        r["name"]      = ap->name;
-        r["city"]      = ap->city;
-        r["country"]   = ap->country;
-        r["iata"]      = ap->iata;
-        r["icao"]      = ap->icao;
-        r["latitude"]  = ap->latitude;
-        r["longitude"] = ap->longitude;
-        return r;
+        return toJson(queryAirport(iata));
     });
 
-    // --- airlines that fly into a given airport (destination) ---
-    CROW_ROUTE(app, "/airlinesForAirport/<string>")
-    ([](const std::string& airportIata) {
-        crow::json::wvalue r;
-        Airport* ap = getAirportByIata(airportIata);
-        if (!ap) {
-            r["error"] = "Airport not found";
-            return r;
-        }
-
-        // collect airline IDs that have this airport as destination
-        std::unordered_map<int, bool> airlineIds;
-        for (const auto& rt : routes) {
-            if (rt.dstAirportId == ap->id) {
-                airlineIds[rt.airlineId] = true;
-            }
-        }
-
-        // build list of airlines
-        std::vector<const Airline*> list;
-        list.reserve(airlineIds.size());
-        for (auto& kv : airlineIds) {
-            auto it = airlinesById.find(kv.first);
-            if (it != airlinesById.end()) {
-                list.push_back(&it->second);
-            }
-        }
-
-        // sort by airline IATA for stable output
-        std::sort(list.begin(), list.end(),
-                  [](const Airline* a, const Airline* b) {
-                      return a->iata < b->iata;
-                  });
-
-        crow::json::wvalue arr = crow::json::wvalue::list(list.size());
-        for (size_t i = 0; i < list.size(); ++i) {
-            arr[i]["id"]      = list[i]->id;
-            arr[i]["name"]    = list[i]->name;
-            arr[i]["iata"]    = list[i]->iata;
-            arr[i]["country"] = list[i]->country;
-        }
-
-        r["airport"]  = ap->iata;
-        r["airlines"] = std::move(arr);
-        return r;
+    // --- airport by ICAO (4 characters) ---
+    CROW_ROUTE(app, "/airport/icao/<string>")
+    ([](const std::string& icao) {
+        return toJson(queryAirportByIcao(icao));
     });
 
-    // --- top 3 destination cities for an airline ---
-    CROW_ROUTE(app, "/topCitiesForAirline/<string>")
-    ([](const std::string& airlineIata) {
-        crow::json::wvalue r;
-        Airline* a = getAirlineByIata(airlineIata);
-        if (!a) {
-            r["error"] = "Airline not found";
-            return r;
-        }
-
-        int n = 3; // for now: always top 3
-
-        // count destination cities
-        std::unordered_map<std::string, int> cityCount;
-        for (const auto& rt : routes) {
-            if (rt.airlineId == a->id) {
-                auto itAp = airportsById.find(rt.dstAirportId);
-                if (itAp != airportsById.end()) {
-                    const Airport& ap = itAp->second;
-                    cityCount[ap.city] += 1;
-                }
+    // --- POST /bulk - resolve many airport/airline codes in one round trip ---
+    // body: {"airports": ["SFO", "KJFK", ...], "airlines": ["UA", "BAW", ...]};
+    // 3-letter airport and 2-letter airline codes are IATA, 4/3-letter are ICAO
+    CROW_ROUTE(app, "/bulk").methods("POST"_method)
+    ([](const crow::request& req) {
+        const size_t BULK_MAX_CODES = 5000;
+        TraceSpan span("bulk.parse");
+        auto body = crow::json::load(req.body);
+        auto fail = [](const char* message) {
+            crow::json::wvalue r;
+            r["error"] = message;
+            return jsonResponse(r.dump());
+        };
+        if (!body) return fail("Invalid JSON");
+
+        // collect each list, upper-cased and deduplicated in request order
+        auto readCodes = [&body](const char* name, std::vector<std::string>& codes) {
+            if (!body.has(name)) return true;
+            if (body[name].t() != crow::json::type::List) return false;
+            std::unordered_map<std::string, bool> seen;
+            for (const auto& v : body[name]) {
+                if (v.t() != crow::json::type::String) return false;
+                std::string code = v.s();
+                for (char& c : code) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+                if (seen.emplace(code, true).second) codes.push_back(std::move(code));
             }
+            return true;
+        };
+        std::vector<std::string> airportCodes, airlineCodes;
+        if (!readCodes("airports", airportCodes) || !readCodes("airlines", airlineCodes)) {
+            return fail("airports and airlines must be arrays of strings");
         }
-
-        struct Row { std::string city; int count; };
-        std::vector<Row> rows;
-        rows.reserve(cityCount.size());
-        for (auto& kv : cityCount) {
-            rows.push_back({ kv.first, kv.second });
+        if (airportCodes.size() + airlineCodes.size() > BULK_MAX_CODES) {
+            return fail("Too many codes (max 5000)");
         }
+        span.end();
 
-        std::sort(rows.begin(), rows.end(),
-                  [](const Row& x, const Row& y) {
-                      return x.count > y.count;
-                  });
+        return jsonResponse(bulkJson(queryBulk(airportCodes, airlineCodes)));
+    });
 
-        if (n > static_cast<int>(rows.size()))
-            n = static_cast<int>(rows.size());
+    // --- GET /suggest?q=&k=&kind=airport|airline&fuzzy=1 - typeahead ---
+    CROW_ROUTE(app, "/suggest")
+    ([](const crow::request& req) {
+        const char* qParam = req.url_params.get("q");
+        const char* kParam = req.url_params.get("k");
+        const char* kindParam = req.url_params.get("kind");
+        const char* fuzzyParam = req.url_params.get("fuzzy");
+        int k = kParam ? std::atoi(kParam) : 10;
+        if (k <= 0) k = 10;
+        if (k > 50) k = 50;
+        bool fuzzy = fuzzyParam && (std::string(fuzzyParam) == "1" || std::string(fuzzyParam) == "true");
+
+        return toJson(querySuggest(qParam ? qParam : "", k, kindParam ? kindParam : "", fuzzy));
+    });
 
-        crow::json::wvalue arr = crow::json::wvalue::list(n);
-        for (int i = 0; i < n; ++i) {
-            arr[i]["city"]   = rows[i].city;
-            arr[i]["routes"] = rows[i].count;
-        }
+    // --- airlines that fly into a given airport (destination) ---
+    CROW_ROUTE(app, "/airlinesForAirport/<string>")
+    ([](const std::string& airportIata) {
+        return toJson(queryAirlinesForAirport(airportIata));
+    });
 
-        r["airline"]    = a->iata;
-        r["top_cities"] = std::move(arr);
-        return r;
+    // --- top N destination cities (or airports / countries) for an airline ---
+    CROW_ROUTE(app, "/topCitiesForAirline/<string>")
+    ([](const crow::request& req, const std::string& airlineIata) {
+        // ?n= (default 3) and ?by=city|airport|country (default city)
+        const char* nParam = req.url_params.get("n");
+        const char* byParam = req.url_params.get("by");
+        int n = nParam ? std::atoi(nParam) : 3;
+        if (n <= 0) n = 3;
+        std::string by = byParam ? byParam : "city";
+        if (by != "airport" && by != "country") by = "city";
+        bool operatedOnly = operatedOnlyParam(req);
+
+        std::string key = "topCitiesForAirline/" + airlineIata + "?n=" + std::to_string(n) + "&by=" + by +
+                          (operatedOnly ? "&operatedOnly" : "");
+        return cachedJson(key, [&] { return queryTopDestinations(airlineIata, n, by, operatedOnly); });
     });
 
     // --- distance between two airports by IATA ---
     CROW_ROUTE(app, "/distance/<string>/<string>")
     ([](const std::string& srcIata, const std::string& dstIata) {
-        crow::json::wvalue r;
-
-        Airport* src = getAirportByIata(srcIata);
-        Airport* dst = getAirportByIata(dstIata);
-
-        if (!src) {
-            r["error"] = "Source airport not found";
-            return r;
-        }
-        if (!dst) {
-            r["error"] = "Destination airport not found";
-            return r;
-        }
-
-        double km = haversineKm(src->latitude, src->longitude,
-                                dst->latitude, dst->longitude);
-        double miles = km * 0.621371;
-
-        r["src"]          = src->iata;
-        r["dst"]          = dst->iata;
-        r["distance_km"]  = km;
-        r["distance_mi"]  = miles;
-        return r;
+        return toJson(queryDistance(srcIata, dstIata));
     });
 
     // --- reports: all airlines sorted by IATA ---
     CROW_ROUTE(app, "/reports/airlines")
     ([] {
-        std::vector<const Airline*> list;
-        list.reserve(airlinesById.size());
-        for (auto& kv : airlinesById) {
-            list.push_back(&kv.second);
-        }
-
-        std::sort(list.begin(), list.end(),
-                  [](const Airline* a, const Airline* b) {
-                      return a->iata < b->iata;
-                  });
-
-        crow::json::wvalue arr = crow::json::wvalue::list(list.size());
-        for (size_t i = 0; i < list.size(); ++i) {
-            arr[i]["id"]       = list[i]->id;
-            arr[i]["name"]     = list[i]->name;
-            arr[i]["iata"]     = list[i]->iata;
-            arr[i]["icao"]     = list[i]->icao;
-            arr[i]["country"]  = list[i]->country;
-            arr[i]["active"]   = list[i]->active;
-        }
-
-        crow::json::wvalue r;
-        r["count"] = static_cast<int>(list.size());
-        r["airlines"] = std::move(arr);
-        return r;
+        return singleFlightJson("reports/airlines", [&] { return queryAirlinesReport(); });
     });
 
     // --- reports: all airports sorted by IATA ---
     CROW_ROUTE(app, "/reports/airports")
     ([] {
-        std::vector<const Airport*> list;
-        list.reserve(airportsById.size());
-        for (auto& kv : airportsById) {
-            list.push_back(&kv.second);
-        }
-
-        std::sort(list.begin(), list.end(),
-                  [](const Airport* a, const Airport* b) {
-                      return a->iata < b->iata;
-                  });
-
-        crow::json::wvalue arr = crow::json::wvalue::list(list.size());
-        for (size_t i = 0; i < list.size(); ++i) {
-            arr[i]["id"]        = list[i]->id;
-            arr[i]["name"]      = list[i]->name;
-            arr[i]["iata"]      = list[i]->iata;
-            arr[i]["city"]      = list[i]->city;
-            arr[i]["country"]   = list[i]->country;
-            arr[i]["latitude"]  = list[i]->latitude;
-            arr[i]["longitude"] = list[i]->longitude;
-        }
-
-        crow::json::wvalue r;
-        r["count"] = static_cast<int>(list.size());
-        r["airports"] = std::move(arr);
-        return r;
+        return singleFlightJson("reports/airports", [&] { return queryAirportsReport(); });
     });
 
     // --- reports: airports served by airline ordered by route counts ---
     CROW_ROUTE(app, "/reports/airlineRoutes/<string>")
-    ([](const std::string& airlineIata) {
-        crow::json::wvalue r;
-        Airline* airline = getAirlineByIata(airlineIata);
-        if (!airline) {
-            r["error"] = "Airline not found";
-            return r;
-        }
-
-        std::unordered_map<int, int> airportCounts;
-        for (const auto& rt : routes) {
-            if (rt.airlineId == airline->id) {
-                airportCounts[rt.srcAirportId] += 1;
-                airportCounts[rt.dstAirportId] += 1;
-            }
-        }
+    ([](const crow::request& req, const std::string& airlineIata) {
+        bool operatedOnly = operatedOnlyParam(req);
+        std::string key = "reports/airlineRoutes/" + airlineIata + (operatedOnly ? "?operatedOnly" : "");
+        return cachedJson(key, [&] { return queryAirlineRoutesReport(airlineIata, operatedOnly); });
+    });
 
-        struct Row {
-            const Airport* airport;
-            int count;
-        };
-        std::vector<Row> rows;
-        rows.reserve(airportCounts.size());
-        for (auto& kv : airportCounts) {
-            auto it = airportsById.find(kv.first);
-            if (it != airportsById.end()) {
-                rows.push_back({ &it->second, kv.second });
-            }
-        }
+    // --- reports: airlines serving airport ordered by route counts ---
+    CROW_ROUTE(app, "/reports/airportRoutes/<string>")
+    ([](const crow::request& req, const std::string& airportIata) {
+        bool operatedOnly = operatedOnlyParam(req);
+        std::string key = "reports/airportRoutes/" + airportIata + (operatedOnly ? "?operatedOnly" : "");
+        return singleFlightJson(key, [&] { return queryAirportRoutesReport(airportIata, operatedOnly); });
+    });
 
-        std::sort(rows.begin(), rows.end(),
-                  [](const Row& a, const Row& b) {
-                      if (a.count == b.count) {
-                          return a.airport->iata < b.airport->iata;
-                      }
-                      return a.count > b.count;
-                  });
-
-        crow::json::wvalue arr = crow::json::wvalue::list(rows.size());
-        for (size_t i = 0; i < rows.size(); ++i) {
-            arr[i]["iata"]      = rows[i].airport->iata;
-            arr[i]["name"]      = rows[i].airport->name;
-            arr[i]["city"]      = rows[i].airport->city;
-            arr[i]["country"]   = rows[i].airport->country;
-            arr[i]["routes"]    = rows[i].count;
-        }
+    // --- reports: airport centrality (betweenness, PageRank) ---
+    CROW_ROUTE(app, "/reports/centrality")
+    ([](const crow::request& req) {
+        const char* limitParam = req.url_params.get("limit");
+        const char* byParam = req.url_params.get("by");
+        int limit = limitParam ? std::atoi(limitParam) : 25;
+        bool byPageRank = byParam && std::string(byParam) == "pagerank";
 
-        r["airline"]["id"]      = airline->id;
-        r["airline"]["name"]    = airline->name;
-        r["airline"]["iata"]    = airline->iata;
-        r["airline"]["country"] = airline->country;
-        r["airports"] = std::move(arr);
-        r["count"] = static_cast<int>(rows.size());
-        return r;
+        return singleFlightJson(req.raw_url, [&] { return queryCentrality(limit, byPageRank); });
     });
 
-    // --- reports: airlines serving airport ordered by route counts ---
-    CROW_ROUTE(app, "/reports/airportRoutes/<string>")
-    ([](const std::string& airportIata) {
-        crow::json::wvalue r;
-        Airport* airport = getAirportByIata(airportIata);
-        if (!airport) {
-            r["error"] = "Airport not found";
-            return r;
+    // --- GET /isochrone/<origins>?maxKm=&maxStops= - reachable airports ---
+    // origins is one IATA code or a comma-separated list
+    CROW_ROUTE(app, "/isochrone/<string>")
+    ([](const crow::request& req, const std::string& originList) {
+        const char* maxKmParam = req.url_params.get("maxKm");
+        const char* maxStopsParam = req.url_params.get("maxStops");
+        double maxKm = std::numeric_limits<double>::infinity();
+        int maxStops = 1;
+        crow::json::wvalue error;
+        if (maxKmParam && (!parseDoubleParam(maxKmParam, maxKm) || maxKm <= 0)) {
+            error["error"] = "maxKm must be a positive number";
+            return error;
         }
-
-        std::unordered_map<int, int> airlineCounts;
-        for (const auto& rt : routes) {
-            if (rt.srcAirportId == airport->id || rt.dstAirportId == airport->id) {
-                airlineCounts[rt.airlineId] += 1;
-            }
+        if (maxStopsParam && (!parseIntParam(maxStopsParam, maxStops) || maxStops < 0
+                              || maxStops > ISOCHRONE_MAX_STOPS)) {
+            error["error"] = "maxStops must be an integer in [0, " + std::to_string(ISOCHRONE_MAX_STOPS) + "]";
+            return error;
         }
 
-        struct Row {
-            const Airline* airline;
-            int count;
-        };
-        std::vector<Row> rows;
-        rows.reserve(airlineCounts.size());
-        for (auto& kv : airlineCounts) {
-            auto it = airlinesById.find(kv.first);
-            if (it != airlinesById.end()) {
-                rows.push_back({ &it->second, kv.second });
-            }
-        }
+        std::vector<std::string> origins;
+        std::stringstream ss(originList);
+        std::string code;
+        while (std::getline(ss, code, ',')) origins.push_back(code);
+
+        return toJson(queryIsochrone(origins, maxKm, maxStops));
+    });
+
+    // --- GET /nearest?lat=&lon=&k= - k nearest airports to a coordinate ---
+    CROW_ROUTE(app, "/nearest")
+    ([](const crow::request& req) {
+        const char* kParam = req.url_params.get("k");
+        double lat, lon;
+        crow::json::wvalue error;
+        if (!parseLatLonParams(req, lat, lon, error)) return error;
+        int k = kParam ? std::atoi(kParam) : 5;
+
+        return toJson(queryNearest(lat, lon, k));
+    });
 
-        std::sort(rows.begin(), rows.end(),
-                  [](const Row& a, const Row& b) {
-                      if (a.count == b.count) {
-                          return a.airline->iata < b.airline->iata;
-                      }
-                      return a.count > b.count;
-                  });
-
-        crow::json::wvalue arr = crow::json::wvalue::list(rows.size());
-        for (size_t i = 0; i < rows.size(); ++i) {
-            arr[i]["iata"]     = rows[i].airline->iata;
-            arr[i]["name"]     = rows[i].airline->name;
-            arr[i]["country"]  = rows[i].airline->country;
-            arr[i]["routes"]   = rows[i].count;
+    // --- GET /within?lat=&lon=&km= - airports inside a radius ---
+    CROW_ROUTE(app, "/within")
+    ([](const crow::request& req) {
+        double lat, lon, km;
+        crow::json::wvalue error;
+        if (!parseLatLonParams(req, lat, lon, error)) return error;
+        if (!parseDoubleParam(req.url_params.get("km"), km) || km <= 0) {
+            error["error"] = "km must be a positive number";
+            return error;
         }
 
-        r["airport"]["id"]      = airport->id;
-        r["airport"]["name"]    = airport->name;
-        r["airport"]["iata"]    = airport->iata;
-        r["airport"]["city"]    = airport->city;
-        r["airport"]["country"] = airport->country;
-        r["airlines"] = std::move(arr);
-        r["count"] = static_cast<int>(rows.size());
-        return r;
+        return toJson(queryWithin(lat, lon, km));
     });
 
     // --- GET /code - return this source file ---
+    // The server is app.cpp plus the engine it links; "code" and "filename"
+    // still carry app.cpp for older clients.
     CROW_ROUTE(app, "/code")
     ([] {
         crow::json::wvalue r;
-        std::ifstream file("app.cpp");
-        if (!file) {
-            r["error"] = "Could not read source file";
-            return r;
+        const char* sources[] = { "app.cpp", "engine.h", "engine.cpp" };
+        std::vector<crow::json::wvalue> files;
+        std::string appSource;
+        for (const char* name : sources) {
+            std::ifstream file(name);
+            if (!file) {
+                r["error"] = std::string("Could not read source file ") + name;
+                return r;
+            }
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            if (files.empty()) appSource = buffer.str();
+            crow::json::wvalue f;
+            f["filename"] = name;
+            f["code"] = buffer.str();
+            files.push_back(std::move(f));
         }
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        r["code"] = buffer.str();
+        r["code"] = appSource;
         r["filename"] = "app.cpp";
+        r["files"] = std::move(files);
         return r;
     });
 
     // --- GET /onehop/<src>/<dst> - find 1-hop connections ---
     CROW_ROUTE(app, "/onehop/<string>/<string>")
     ([](const std::string& srcIata, const std::string& dstIata) {
-        crow::json::wvalue r;
+        return cachedJson("onehop/" + srcIata + "/" + dstIata, [&] { return queryOneHop(srcIata, dstIata); });
+    });
 
-        Airport* src = getAirportByIata(srcIata);
-        Airport* dst = getAirportByIata(dstIata);
+    // --- GET /components/<iata> - connected component membership ---
+    CROW_ROUTE(app, "/components/<string>")
+    ([](const std::string& iata) {
+        return toJson(queryComponent(iata));
+    });
 
-        if (!src) {
-            r["error"] = "Source airport not found";
-            return r;
-        }
-        if (!dst) {
-            r["error"] = "Destination airport not found";
-            return r;
-        }
+    // --- GET /components/<src>/<dst> - O(1) reachability verdict ---
+    CROW_ROUTE(app, "/components/<string>/<string>")
+    ([](const std::string& srcIata, const std::string& dstIata) {
+        return toJson(queryReachability(srcIata, dstIata));
+    });
 
-        // Find airports reachable from src
-        std::unordered_map<int, bool> fromSrc;
-        for (const auto& rt : routes) {
-            if (rt.srcAirportId == src->id) {
-                fromSrc[rt.dstAirportId] = true;
-            }
-        }
+    // --- reports: airports per timezone (or per UTC offset with ?by=offset) ---
+    CROW_ROUTE(app, "/reports/timezones")
+    ([](const crow::request& req) {
+        const char* byParam = req.url_params.get("by");
+        bool byOffset = byParam && std::string(byParam) == "offset";
 
-        // Find airports that can reach dst
-        std::unordered_map<int, bool> toDst;
-        for (const auto& rt : routes) {
-            if (rt.dstAirportId == dst->id) {
-                toDst[rt.srcAirportId] = true;
-            }
-        }
+        return singleFlightJson(req.raw_url, [&] { return queryTimezonesReport(byOffset); });
+    });
 
-        // Find intersection (connecting airports)
-        std::vector<const Airport*> connections;
-        for (auto& kv : fromSrc) {
-            if (toDst.find(kv.first) != toDst.end()) {
-                auto it = airportsById.find(kv.first);
-                if (it != airportsById.end()) {
-                    connections.push_back(&it->second);
-                }
-            }
+    // --- GET /airports/timezone?tz=<name> or ?utcOffset=<hours> ---
+    // optional ?type=airport keeps only rows of that type
+    CROW_ROUTE(app, "/airports/timezone")
+    ([](const crow::request& req) {
+        const char* tzParam = req.url_params.get("tz");
+        const char* offsetParam = req.url_params.get("utcOffset");
+        const char* typeParam = req.url_params.get("type");
+        if (!tzParam && !offsetParam) {
+            crow::json::wvalue r;
+            r["error"] = "tz or utcOffset is required";
+            return r;
         }
 
-        // Calculate distances and sort by total distance
-        struct Connection {
-            const Airport* hub;
-            double leg1_km;
-            double leg2_km;
-            double total_km;
+        std::string type = typeParam ? typeParam : "";
+        if (tzParam) return toJson(queryAirportsByTimezone(tzParam, type));
+        return toJson(queryAirportsByUtcOffset(std::atof(offsetParam), type));
+    });
+
+    // --- GET /routes/equipment/<code> - routes flown with an aircraft type ---
+    // optional filters: ?airline=<iata>&src=<iata>&dst=<iata>&limit=
+    CROW_ROUTE(app, "/routes/equipment/<string>")
+    ([](const crow::request& req, const std::string& code) {
+        auto param = [&req](const char* name) {
+            const char* v = req.url_params.get(name);
+            return std::string(v ? v : "");
         };
+        const char* limitParam = req.url_params.get("limit");
+        int limit = limitParam ? std::atoi(limitParam) : 100;
 
-        std::vector<Connection> results;
-        for (const Airport* hub : connections) {
-            double leg1 = haversineKm(src->latitude, src->longitude, hub->latitude, hub->longitude);
-            double leg2 = haversineKm(hub->latitude, hub->longitude, dst->latitude, dst->longitude);
-            results.push_back({hub, leg1, leg2, leg1 + leg2});
-        }
+        return toJson(queryRoutesByEquipment(code, param("airline"), param("src"), param("dst"), limit));
+    });
 
-        // Sort by total distance (ascending)
-        std::sort(results.begin(), results.end(),
-                  [](const Connection& a, const Connection& b) {
-                      return a.total_km < b.total_km;
-                  });
-
-        crow::json::wvalue arr = crow::json::wvalue::list(results.size());
-        for (size_t i = 0; i < results.size(); ++i) {
-            arr[i]["hub_iata"] = results[i].hub->iata;
-            arr[i]["hub_name"] = results[i].hub->name;
-            arr[i]["hub_city"] = results[i].hub->city;
-            arr[i]["leg1_km"] = results[i].leg1_km;
-            arr[i]["leg2_km"] = results[i].leg2_km;
-            arr[i]["total_km"] = results[i].total_km;
-            arr[i]["total_mi"] = results[i].total_km * 0.621371;
-        }
+    // --- reports: equipment codes by number of routes ---
+    CROW_ROUTE(app, "/reports/equipment")
+    ([](const crow::request& req) {
+        const char* limitParam = req.url_params.get("limit");
+        int limit = limitParam ? std::atoi(limitParam) : 0;
 
-        r["src"] = src->iata;
-        r["dst"] = dst->iata;
-        r["connections"] = std::move(arr);
-        r["count"] = static_cast<int>(results.size());
-        return r;
+        return singleFlightJson(req.raw_url, [&] { return queryEquipmentReport(limit); });
     });
 
-    // --- POST /airline - insert new airline ---
-    CROW_ROUTE(app, "/airline").methods("POST"_method)
+    // --- reports: fleet mix (equipment codes) for an airline ---
+    CROW_ROUTE(app, "/reports/fleetMix/<string>")
+    ([](const std::string& airlineIata) {
+        return singleFlightJson("reports/fleetMix/" + airlineIata, [&] { return queryFleetMix(airlineIata); });
+    });
+
+    // --- reports: component summary ---
+    CROW_ROUTE(app, "/reports/components")
     ([](const crow::request& req) {
-        crow::json::wvalue r;
+        const char* limitParam = req.url_params.get("limit");
+        int limit = limitParam ? std::atoi(limitParam) : 10;
+
+        return singleFlightJson(req.raw_url, [&] { return queryComponentsReport(limit); });
+    });
+
+    // --- GET /hops/<src>/<dst> - precomputed minimum hop count ---
+    CROW_ROUTE(app, "/hops/<string>/<string>")
+    ([](const crow::request& req, const std::string& srcIata, const std::string& dstIata) {
+        const char* maxStopsParam = req.url_params.get("maxStops");
+        int maxStops = maxStopsParam ? std::atoi(maxStopsParam) : -1;
+
+        return toJson(queryHops(srcIata, dstIata, maxStops));
+    });
+
+    // --- POST /hops - bulk hop counts for many pairs ---
+    // body: {"pairs": [["SFO","JFK"], ...], "maxStops": 1}
+    CROW_ROUTE(app, "/hops").methods("POST"_method)
+    ([](const crow::request& req) {
+        TraceSpan span("hops.parse");
         auto body = crow::json::load(req.body);
-        if (!body) {
-            r["error"] = "Invalid JSON";
-            return r;
+        auto fail = [](const char* message) {
+            crow::json::wvalue r;
+            r["error"] = message;
+            return jsonResponse(r.dump());
+        };
+        if (!body || !body.has("pairs") || body["pairs"].t() != crow::json::type::List) {
+            return fail("Invalid JSON");
         }
-
-        Airline a;
-        a.id = body["id"].i();
-        a.name = body["name"].s();
-        a.iata = body["iata"].s();
-        a.icao = body.has("icao") ? std::string(body["icao"].s()) : "";
-        a.callsign = body.has("callsign") ? std::string(body["callsign"].s()) : "";
-        a.country = body.has("country") ? std::string(body["country"].s()) : "";
-        a.active = body.has("active") ? std::string(body["active"].s()) : "Y";
-
-        if (airlinesById.find(a.id) != airlinesById.end()) {
-            r["error"] = "Airline ID already exists";
-            return r;
+        if (body.has("maxStops") && body["maxStops"].t() != crow::json::type::Number) {
+            return fail("maxStops must be a number");
         }
 
-        airlinesById[a.id] = a;
-        if (!a.iata.empty()) {
-            airlinesByIata[a.iata] = &airlinesById[a.id];
+        // negative = no limit; hop counts saturate long before 100
+        double maxStopsValue = body.has("maxStops") ? body["maxStops"].d() : -1;
+        int maxStops = maxStopsValue < 0 ? -1 : static_cast<int>(std::min(maxStopsValue, 100.0));
+        std::vector<std::vector<std::string>> pairs;
+        pairs.reserve(body["pairs"].size());
+        for (const auto& p : body["pairs"]) {
+            pairs.emplace_back();
+            if (p.t() != crow::json::type::List) continue;
+            for (const auto& code : p) {
+                if (code.t() != crow::json::type::String) return fail("pairs must hold airport code strings");
+                pairs.back().push_back(code.s());
+            }
         }
+        span.end();
 
-        r["success"] = true;
-        r["message"] = "Airline inserted successfully";
-        r["id"] = a.id;
-        return r;
+        return jsonResponse(toJson(queryHopsBulk(pairs, maxStops)).dump());
+    });
+
+    // --- POST /airline - insert new airline ---
+    CROW_ROUTE(app, "/airline").methods("POST"_method)
+    ([](const crow::request& req) {
+        auto body = crow::json::load(req.body);
+        if (!body) return invalidJson();
+        return toJson(addAirline(body["id"].i(), airlineFields(body)));
     });
 
     // --- PUT /airline/<id> - modify airline ---
     CROW_ROUTE(app, "/airline/<int>").methods("PUT"_method)
     ([](const crow::request& req, int id) {
-        crow::json::wvalue r;
-        auto it = airlinesById.find(id);
-        if (it == airlinesById.end()) {
-            r["error"] = "Airline ID not found";
-            return r;
-        }
-
         auto body = crow::json::load(req.body);
-        if (!body) {
-            r["error"] = "Invalid JSON";
-            return r;
-        }
-
-        // Update only fields that are specified
-        Airline& a = it->second;
-        if (body.has("name")) a.name = std::string(body["name"].s());
-        if (body.has("alias")) a.alias = std::string(body["alias"].s());
-        if (body.has("icao")) a.icao = std::string(body["icao"].s());
-        if (body.has("callsign")) a.callsign = std::string(body["callsign"].s());
-        if (body.has("country")) a.country = std::string(body["country"].s());
-        if (body.has("active")) a.active = std::string(body["active"].s());
-        
-        // Handle IATA update - need to update index
-        if (body.has("iata")) {
-            std::string newIata = std::string(body["iata"].s());
-            if (newIata != a.iata) {
-                if (!a.iata.empty()) {
-                    airlinesByIata.erase(a.iata);
-                }
-                a.iata = newIata;
-                if (!a.iata.empty()) {
-                    airlinesByIata[a.iata] = &a;
-                }
-            }
-        }
-
-        r["success"] = true;
-        r["message"] = "Airline modified successfully";
-        r["id"] = id;
-        return r;
+        if (!body) return invalidJson();
+        return toJson(updateAirline(id, airlineFields(body)));
     });
 
     // --- DELETE /airline/<id> - remove airline ---
     CROW_ROUTE(app, "/airline/<int>").methods("DELETE"_method)
     ([](int id) {
-        crow::json::wvalue r;
-        auto it = airlinesById.find(id);
-        if (it == airlinesById.end()) {
-            r["error"] = "Airline not found";
-            return r;
-        }
-
-        // Remove from IATA index
-        if (!it->second.iata.empty()) {
-            airlinesByIata.erase(it->second.iata);
-        }
-
-        // Remove routes for this airline
-        routes.erase(
-            std::remove_if(routes.begin(), routes.end(),
-                [id](const Route& rt) { return rt.airlineId == id; }),
-            routes.end()
-        );
-
-        airlinesById.erase(it);
-
-        r["success"] = true;
-        r["message"] = "Airline and associated routes removed";
-        return r;
+        return toJson(removeAirline(id));
     });
 
     // --- POST /airport - insert new airport ---
     CROW_ROUTE(app, "/airport").methods("POST"_method)
     ([](const crow::request& req) {
-        crow::json::wvalue r;
         auto body = crow::json::load(req.body);
-        if (!body) {
-            r["error"] = "Invalid JSON";
-            return r;
-        }
-
-        Airport ap;
-        ap.id = body["id"].i();
-        ap.name = body["name"].s();
-        ap.iata = body["iata"].s();
-        ap.city = body.has("city") ? std::string(body["city"].s()) : "";
-        ap.country = body.has("country") ? std::string(body["country"].s()) : "";
-        ap.icao = body.has("icao") ? std::string(body["icao"].s()) : "";
-        ap.latitude = body.has("latitude") ? body["latitude"].d() : 0.0;
-        ap.longitude = body.has("longitude") ? body["longitude"].d() : 0.0;
-
-        if (airportsById.find(ap.id) != airportsById.end()) {
-            r["error"] = "Airport ID already exists";
-            return r;
-        }
-
-        airportsById[ap.id] = ap;
-        if (!ap.iata.empty()) {
-            airportsByIata[ap.iata] = &airportsById[ap.id];
-        }
-
-        r["success"] = true;
-        r["message"] = "Airport inserted successfully";
-        r["id"] = ap.id;
-        return r;
+        if (!body) return invalidJson();
+        return toJson(addAirport(body["id"].i(), airportFields(body)));
     });
 
     // --- PUT /airport/<id> - modify airport ---
     CROW_ROUTE(app, "/airport/<int>").methods("PUT"_method)
     ([](const crow::request& req, int id) {
-        crow::json::wvalue r;
-        auto it = airportsById.find(id);
-        if (it == airportsById.end()) {
-            r["error"] = "Airport ID not found";
-            return r;
-        }
-
         auto body = crow::json::load(req.body);
-        if (!body) {
-            r["error"] = "Invalid JSON";
-            return r;
-        }
-
-        // Update only fields that are specified
-        Airport& ap = it->second;
-        if (body.has("name")) ap.name = std::string(body["name"].s());
-        if (body.has("city")) ap.city = std::string(body["city"].s());
-        if (body.has("country")) ap.country = std::string(body["country"].s());
-        if (body.has("icao")) ap.icao = std::string(body["icao"].s());
-        if (body.has("latitude")) ap.latitude = body["latitude"].d();
-        if (body.has("longitude")) ap.longitude = body["longitude"].d();
-        
-        // Handle IATA update - need to update index
-        if (body.has("iata")) {
-            std::string newIata = std::string(body["iata"].s());
-            if (newIata != ap.iata) {
-                if (!ap.iata.empty()) {
-                    airportsByIata.erase(ap.iata);
-                }
-                ap.iata = newIata;
-                if (!ap.iata.empty()) {
-                    airportsByIata[ap.iata] = &ap;
-                }
-            }
-        }
-
-        r["success"] = true;
-        r["message"] = "Airport modified successfully";
-        r["id"] = id;
-        return r;
+        if (!body) return invalidJson();
+        return toJson(updateAirport(id, airportFields(body)));
     });
 
     // --- DELETE /airport/<id> - remove airport ---
     CROW_ROUTE(app, "/airport/<int>").methods("DELETE"_method)
     ([](int id) {
-        crow::json::wvalue r;
-        auto it = airportsById.find(id);
-        if (it == airportsById.end()) {
-            r["error"] = "Airport not found";
-            return r;
-        }
-
-        // Remove from IATA index
-        if (!it->second.iata.empty()) {
-            airportsByIata.erase(it->second.iata);
-        }
-
-        // Remove routes to/from this airport
-        routes.erase(
-            std::remove_if(routes.begin(), routes.end(),
-                [id](const Route& rt) { return rt.srcAirportId == id || rt.dstAirportId == id; }),
-            routes.end()
-        );
-
-        airportsById.erase(it);
-
-        r["success"] = true;
-        r["message"] = "Airport and associated routes removed";
-        return r;
+        return toJson(removeAirport(id));
     });
 
     // --- POST /route - insert new route ---
     CROW_ROUTE(app, "/route").methods("POST"_method)
     ([](const crow::request& req) {
-        crow::json::wvalue r;
         auto body = crow::json::load(req.body);
-        if (!body) {
-            r["error"] = "Invalid JSON";
-            return r;
-        }
-
-        Route rt;
-        rt.airlineId = body["airlineId"].i();
-        rt.srcAirportId = body["srcAirportId"].i();
-        rt.dstAirportId = body["dstAirportId"].i();
-        rt.stops = body.has("stops") ? body["stops"].i() : 0;
+        if (!body) return invalidJson();
+        RouteFields fields;
+        fields.airlineId = body["airlineId"].i();
+        fields.srcAirportId = body["srcAirportId"].i();
+        fields.dstAirportId = body["dstAirportId"].i();
+        fields.stops = body.has("stops") ? static_cast<int>(body["stops"].i()) : 0;
+        fields.codeshare = body.has("codeshare") && body["codeshare"].t() == crow::json::type::True;
+        readString(body, "equipment", fields.equipment);
+        return toJson(addRoute(fields));
+    });
 
-        // Validate foreign keys
-        if (airlinesById.find(rt.airlineId) == airlinesById.end()) {
-            r["error"] = "Invalid airline ID";
-            return r;
-        }
-        if (airportsById.find(rt.srcAirportId) == airportsById.end()) {
-            r["error"] = "Invalid source airport ID";
-            return r;
-        }
-        if (airportsById.find(rt.dstAirportId) == airportsById.end()) {
-            r["error"] = "Invalid destination airport ID";
-            return r;
-        }
+    // --- DELETE /route - remove route ---
+    CROW_ROUTE(app, "/route").methods("DELETE"_method)
+    ([](const crow::request& req) {
+        auto body = crow::json::load(req.body);
+        if (!body) return invalidJson();
+        return toJson(removeRoute(body["airlineId"].i(), body["srcAirportId"].i(), body["dstAirportId"].i()));
+    });
 
-        routes.push_back(rt);
+    // --- GET /metrics - Prometheus text format ---
+    CROW_ROUTE(app, "/metrics")
+    ([] {
+        crow::response res(200);
+        res.set_header("Content-Type", "text/plain; version=0.0.4");
+        res.body = renderMetrics();
+        return res;
+    });
 
-        r["success"] = true;
-        r["message"] = "Route inserted successfully";
+    // --- GET/POST /admin/tracing - span recorder status and runtime toggle ---
+    // POST body: {"enabled": true|false}
+    CROW_ROUTE(app, "/admin/tracing").methods("GET"_method, "POST"_method)
+    ([](const crow::request& req) {
+        crow::json::wvalue r;
+        if (req.method == crow::HTTPMethod::Post) {
+            auto body = crow::json::load(req.body);
+            if (!body || !body.has("enabled")) {
+                r["error"] = "Invalid JSON";
+                return r;
+            }
+            tracingEnabled.store(body["enabled"].t() == crow::json::type::True);
+        }
+        r["enabled"] = tracingEnabled.load();
+        r["ring_events"] = static_cast<int>(TRACE_RING_EVENTS);
+        r["threads"] = static_cast<int>(traceThreadCount());
         return r;
     });
 
-    // --- DELETE /route - remove route ---
-    CROW_ROUTE(app, "/route").methods("DELETE"_method)
+    // --- GET/POST /admin/slowlog - recent slow requests; POST sets the threshold ---
+    // POST body: {"threshold_ms": 50} (0 turns the log off)
+    CROW_ROUTE(app, "/admin/slowlog").methods("GET"_method, "POST"_method)
     ([](const crow::request& req) {
-        crow::json::wvalue r;
-        auto body = crow::json::load(req.body);
-        if (!body) {
-            r["error"] = "Invalid JSON";
-            return r;
+        if (req.method == crow::HTTPMethod::Post) {
+            auto body = crow::json::load(req.body);
+            crow::json::wvalue r;
+            if (!body || !body.has("threshold_ms")) {
+                r["error"] = "Invalid JSON";
+                return jsonResponse(r.dump());
+            }
+            if (body["threshold_ms"].t() != crow::json::type::Number ||
+                !(body["threshold_ms"].d() >= 0) || !std::isfinite(body["threshold_ms"].d())) {
+                r["error"] = "threshold_ms must be a non-negative number";
+                return jsonResponse(r.dump());
+            }
+            slowQueryLog().setThresholdMs(body["threshold_ms"].d());
         }
+        return jsonResponse(slowQueryLog().recentJson());
+    });
 
-        int airlineId = body["airlineId"].i();
-        int srcId = body["srcAirportId"].i();
-        int dstId = body["dstAirportId"].i();
-
-        size_t before = routes.size();
-        routes.erase(
-            std::remove_if(routes.begin(), routes.end(),
-                [airlineId, srcId, dstId](const Route& rt) {
-                    return rt.airlineId == airlineId &&
-                           rt.srcAirportId == srcId &&
-                           rt.dstAirportId == dstId;
-                }),
-            routes.end()
-        );
-
-        if (routes.size() == before) {
-            r["error"] = "Route not found";
-            return r;
+    // --- GET/POST /admin/reload - reload the .dat files and swap them in ---
+    // POST starts a background load of DATA_DIR; GET reports the last one.
+    CROW_ROUTE(app, "/admin/reload").methods("GET"_method, "POST"_method)
+    ([dataDir](const crow::request& req) {
+        crow::json::wvalue r;
+        if (req.method == crow::HTTPMethod::Post && !startReload(dataDir)) {
+            r["error"] = "Reload already running";
         }
+        ReloadStatus status = reloadStatus();
+        r["running"] = status.running;
+        r["reloads"] = status.reloads;
+        r["failures"] = status.failures;
+        r["version"] = status.version;
+        r["load_ms"] = status.loadMs;
+        r["swap_us"] = status.swapUs;
+        r["last_error"] = status.lastError;
+        return r;
+    });
 
-        r["success"] = true;
-        r["message"] = "Route removed";
+    // --- GET /admin/trace[?clear=1] - Chrome trace JSON of recorded spans ---
+    CROW_ROUTE(app, "/admin/trace")
+    ([](const crow::request& req) {
+        const char* clearParam = req.url_params.get("clear");
+        bool clear = clearParam && (std::string(clearParam) == "1" || std::string(clearParam) == "true");
+        return jsonResponse(renderChromeTrace(clear));
+    });
+
+    // --- GET /cache/stats - result cache and single-flight counters ---
+    CROW_ROUTE(app, "/cache/stats")
+    ([] {
+        crow::json::wvalue r = resultCache().stats();
+        r["singleflight"] = singleFlight().stats();
         return r;
     });
 
@@ -1023,5 +1913,8 @@ int main() {
     const char* portEnv = std::getenv("PORT");
     int port = portEnv ? std::stoi(portEnv) : 8080;
     app.port(port).multithreaded().run();
+
+    stopAnalyticsWorker();
+    analytics.join();
     return 0;
 }
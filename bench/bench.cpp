@@ -0,0 +1,296 @@
+// Microbenchmarks for the loaders, lookups and query kernels behind the
+// HTTP endpoints, linked against the engine library. Uses Google Benchmark;
+// from the repo root:
+//
+//   make bench_app
+//   ./bench_app --benchmark_format=json --benchmark_out=bench.json
+//
+// Compare two runs with Google Benchmark's tools/compare.py.
+//
+// BENCH_DATA_DIR  directory holding the .dat files (default ".")
+// BENCH_SCALES    comma-separated dataset scales (default "1,4,16"). Scale 1
+//                 is the bundled data; scale k is grown k-fold in routes by
+//                 bench/datagen.h and written to /tmp/bench_data_x<k>.
+//
+// bench/scaling.sh runs the query benchmarks over several scales and charts
+// latency against dataset size.
+
+#include "../engine.h"
+
+#include "datagen.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+
+namespace {
+
+std::string dataDir() {
+    const char* dir = std::getenv("BENCH_DATA_DIR");
+    return dir ? dir : ".";
+}
+
+std::vector<int> benchScales() {
+    const char* env = std::getenv("BENCH_SCALES");
+    std::vector<int> scales;
+    std::stringstream ss(env ? env : "1,4,16");
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int k = std::atoi(item.c_str());
+        if (k > 0) scales.push_back(k);
+    }
+    if (scales.empty()) scales.push_back(1);
+    return scales;
+}
+
+// Loaders log to stderr; keep benchmark output clean while they run.
+struct QuietStderr {
+    std::streambuf* saved = std::cerr.rdbuf(nullptr);
+    ~QuietStderr() {
+        std::cerr.rdbuf(saved);
+        std::cerr.clear();
+    }
+};
+
+// Generates the dataset for `scale` and returns its directory; scale 1 is
+// the bundled data as is.
+std::string datasetDir(int scale) {
+    if (scale == 1) return dataDir();
+    std::string dir = "/tmp/bench_data_x" + std::to_string(scale);
+    std::string mkdir = "mkdir -p " + dir;
+    if (std::system(mkdir.c_str()) != 0) return dataDir();
+
+    datagen::Options opt;
+    opt.scale = scale;
+    std::string error;
+    if (!datagen::generate(dataDir(), dir, opt, nullptr, &error)) {
+        std::cerr << "datagen: " << error << "\n";
+        return dataDir();
+    }
+    return dir;
+}
+
+int loadedScale = 0;
+std::string loadedDir;
+
+// Loads the dataset for `scale` (if it is not already loaded) and builds the
+// same derived indexes as the server. Runs outside the timed region.
+void useDataset(int scale) {
+    if (loadedScale == scale) return;
+    std::string dir = datasetDir(scale);
+    QuietStderr quiet;
+    EngineOptions options;
+    options.graphAirportsOnly = envEnabled("GRAPH_AIRPORTS_ONLY", false);
+    if (const char* threads = std::getenv("ANALYTICS_THREADS")) {
+        options.analyticsThreads = static_cast<unsigned>(std::max(std::atoi(threads), 0));
+    }
+    setEngineOptions(options);
+    loadDataset(dir);
+    loadedScale = scale;
+    loadedDir = dir;
+}
+
+void setDatasetCounters(benchmark::State& state) {
+    state.counters["airlines"] = static_cast<double>(airlinesById.size());
+    state.counters["airports"] = static_cast<double>(airportsById.size());
+    state.counters["routes"] = static_cast<double>(routes.size());
+}
+
+// ---------- Parsing and loading ----------
+
+void BM_ParseCsvLine(benchmark::State& state) {
+    const std::string line =
+        "3469,\"San Francisco International Airport\",\"San Francisco\",\"United States\",\"SFO\","
+        "\"KSFO\",37.61899948120117,-122.375,13,-8,\"A\",\"America/Los_Angeles\",\"airport\",\"OurAirports\"";
+    for (auto _ : state) {
+        auto fields = parseCsvLine(line);
+        benchmark::DoNotOptimize(fields.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(line.size()));
+}
+
+// Cold-start load of one file: every iteration starts from an empty Dataset
+// (fresh string pool and slot indexes), created and destroyed untimed.
+template <typename Loader>
+void runLoad(benchmark::State& state, int scale, const char* file, Loader load) {
+    useDataset(scale);
+    std::string path = loadedDir + "/" + file;
+    QuietStderr quiet;
+    size_t rows = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto d = std::make_unique<Dataset>();
+        state.ResumeTiming();
+        rows = load(*d, path);
+        state.PauseTiming();
+        d.reset();
+        state.ResumeTiming();
+    }
+    setDatasetCounters(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(rows));
+}
+
+void BM_LoadAirlines(benchmark::State& state, int scale) {
+    runLoad(state, scale, "airlines.dat", [](Dataset& d, const std::string& path) {
+        loadAirlines(d, path);
+        return d.airlinesById.size();
+    });
+}
+
+void BM_LoadAirports(benchmark::State& state, int scale) {
+    runLoad(state, scale, "airports.dat", [](Dataset& d, const std::string& path) {
+        loadAirports(d, path);
+        return d.airportsById.size();
+    });
+}
+
+void BM_LoadRoutes(benchmark::State& state, int scale) {
+    runLoad(state, scale, "routes.dat", [](Dataset& d, const std::string& path) {
+        loadRoutes(d, path);
+        return d.routes.size();
+    });
+}
+
+// ---------- Lookups ----------
+
+void BM_GetAirportByIata(benchmark::State& state, int scale) {
+    useDataset(scale);
+    std::vector<std::string> codes;
+    for (const auto& kv : airportsByIata) codes.push_back(kv.first);
+    codes.push_back("ZZZ"); // one miss per pass
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(getAirportByIata(codes[i]));
+        if (++i == codes.size()) i = 0;
+    }
+    setDatasetCounters(state);
+}
+
+void BM_HaversineKm(benchmark::State& state, int scale) {
+    useDataset(scale);
+    std::vector<std::pair<double, double>> coords;
+    for (const auto& kv : airportsById) coords.emplace_back(kv.second.latitude, kv.second.longitude);
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& a = coords[i];
+        const auto& b = coords[coords.size() - 1 - i];
+        benchmark::DoNotOptimize(haversineKm(a.first, a.second, b.first, b.second));
+        if (++i == coords.size()) i = 0;
+    }
+}
+
+// ---------- Analytics kernels ----------
+
+// The hop matrix takes n^2 / 2 bytes and centrality runs a BFS per airport;
+// past this many airports the kernels are skipped rather than run for hours.
+const size_t KERNEL_MAX_AIRPORTS = 32768;
+
+bool kernelTooLarge(benchmark::State& state) {
+    if (airportsById.size() <= KERNEL_MAX_AIRPORTS) return false;
+    state.SkipWithError("dataset has more airports than KERNEL_MAX_AIRPORTS");
+    return true;
+}
+
+void BM_HopMatrix(benchmark::State& state, int scale) {
+    useDataset(scale);
+    if (kernelTooLarge(state)) return;
+    auto graph = routeGraphSnapshot();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(computeHopMatrix(graph).get());
+    }
+    setDatasetCounters(state);
+}
+
+void BM_Centrality(benchmark::State& state, int scale) {
+    useDataset(scale);
+    if (kernelTooLarge(state)) return;
+    auto graph = routeGraphSnapshot();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(computeCentrality(graph).get());
+    }
+    setDatasetCounters(state);
+}
+
+// Graph build plus Tarjan, as after a route delete that drops an edge.
+void BM_Components(benchmark::State& state, int scale) {
+    useDataset(scale);
+    for (auto _ : state) {
+        recomputeComponents();
+    }
+    setDatasetCounters(state);
+}
+
+// ---------- Queries ----------
+
+// Runs a query as the handler would on a cache miss, lock included. JSON
+// serialisation lives in app.cpp and is not timed here.
+template <typename Query>
+void runQuery(benchmark::State& state, int scale, Query query) {
+    useDataset(scale);
+    for (auto _ : state) {
+        auto result = query();
+        benchmark::DoNotOptimize(result);
+    }
+    setDatasetCounters(state);
+}
+
+void registerScale(int scale) {
+    std::string suffix = "/scale:" + std::to_string(scale);
+    auto add = [&](const std::string& name, auto fn) {
+        benchmark::RegisterBenchmark((name + suffix).c_str(), fn, scale);
+    };
+    // multi-threaded and slow: wall time, in milliseconds
+    auto addKernel = [&](const std::string& name, auto fn) {
+        benchmark::RegisterBenchmark((name + suffix).c_str(), fn, scale)
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+    };
+    auto addQuery = [&](const std::string& name, auto query) {
+        benchmark::RegisterBenchmark((name + suffix).c_str(), [query](benchmark::State& state, int k) {
+            runQuery(state, k, query);
+        }, scale);
+    };
+
+    add("BM_GetAirportByIata", BM_GetAirportByIata);
+    add("BM_HaversineKm", BM_HaversineKm);
+    addQuery("BM_AirlinesForAirport/ATL", [] { return queryAirlinesForAirport("ATL"); });
+    addQuery("BM_TopDestinations/UA/city", [] { return queryTopDestinations("UA", 3, "city", false); });
+    addQuery("BM_TopDestinations/UA/country", [] { return queryTopDestinations("UA", 10, "country", false); });
+    addQuery("BM_Distance/SFO/JFK", [] { return queryDistance("SFO", "JFK"); });
+    addQuery("BM_AirlinesReport", [] { return queryAirlinesReport(); });
+    addQuery("BM_AirportsReport", [] { return queryAirportsReport(); });
+    addQuery("BM_AirlineRoutesReport/UA", [] { return queryAirlineRoutesReport("UA", false); });
+    addQuery("BM_AirportRoutesReport/ATL", [] { return queryAirportRoutesReport("ATL", false); });
+    addQuery("BM_OneHop/SFO/JFK", [] { return queryOneHop("SFO", "JFK"); });
+    addQuery("BM_OneHop/LHR/SYD", [] { return queryOneHop("LHR", "SYD"); });
+    addQuery("BM_Suggest/san", [] { return querySuggest("san", 10, "", false); });
+    addQuery("BM_RoutesByEquipment/738", [] { return queryRoutesByEquipment("738", "", "", "", 100); });
+    addQuery("BM_Isochrone/SFO/3000km", [] {
+        return queryIsochrone({ "SFO" }, 3000.0, 2);
+    });
+    addQuery("BM_Isochrone/LHR+JFK/unbounded", [] {
+        return queryIsochrone({ "LHR", "JFK" }, std::numeric_limits<double>::infinity(), 1);
+    });
+    addKernel("BM_Components", BM_Components);
+    addKernel("BM_HopMatrix", BM_HopMatrix);
+    addKernel("BM_Centrality", BM_Centrality);
+
+    add("BM_LoadAirlines", BM_LoadAirlines);
+    add("BM_LoadAirports", BM_LoadAirports);
+    add("BM_LoadRoutes", BM_LoadRoutes);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    benchmark::RegisterBenchmark("BM_ParseCsvLine", BM_ParseCsvLine);
+    for (int scale : benchScales()) registerScale(scale);
+    benchmark::AddCustomContext("dataset", dataDir());
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,45 @@
+// Command-line front end for bench/datagen.h.
+//
+//   g++ bench/datagen.cpp -std=c++17 -O2 -o datagen
+//   ./datagen --out /tmp/x100 --scale 100
+//   PORT=8080 (cd /tmp/x100 && /path/to/server)   # the server reads ./*.dat
+
+#include "datagen.h"
+
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    datagen::Options opt;
+    std::string seedDir = ".";
+    std::string outDir;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        const char* v = argv[i + 1];
+        if (arg == "--out") outDir = v;
+        else if (arg == "--seed-data") seedDir = v;
+        else if (arg == "--scale") opt.scale = std::atof(v);
+        else if (arg == "--airport-scale") opt.airportScale = std::atof(v);
+        else if (arg == "--airline-scale") opt.airlineScale = std::atof(v);
+        else if (arg == "--spoke-share") opt.spokeShare = std::atof(v);
+        else if (arg == "--codeshare") opt.codeshareRate = std::atof(v);
+        else if (arg == "--seed") opt.seed = std::strtoull(v, nullptr, 10);
+        else outDir.clear(), i = argc;
+    }
+    if (outDir.empty() || argc % 2 == 0) {
+        std::cerr << "usage: datagen --out DIR [--seed-data DIR] [--scale S] [--airport-scale A]\n"
+                     "               [--airline-scale L] [--spoke-share F] [--codeshare F] [--seed N]\n";
+        return 2;
+    }
+
+    datagen::Summary summary;
+    std::string error;
+    if (!datagen::generate(seedDir, outDir, opt, &summary, &error)) {
+        std::cerr << "datagen: " << error << "\n";
+        return 1;
+    }
+    if (!error.empty()) std::cerr << "warning: " << error << "\n";
+    std::cerr << "Wrote " << summary.airports << " airports, " << summary.airlines << " airlines, "
+              << summary.routes << " routes to " << outDir << "\n";
+    return 0;
+}
@@ -0,0 +1,442 @@
+// Synthetic OpenFlights-style dataset generator. Grows the bundled
+// airports.dat / airlines.dat / routes.dat by a scale factor and writes files
+// the server's loaders read unchanged. Used by bench/datagen.cpp (CLI) and
+// the scaling runs in bench/bench.cpp.
+//
+// The bundled rows are kept verbatim, so real codes (SFO, UA, ...) still
+// resolve and the real hubs stay hubs. On top of them:
+//  - airports are placed around real airports picked by route degree, so
+//    density follows real geography; each gets a degree weight bootstrapped
+//    from the real degree distribution (heavy-tailed)
+//  - airlines get a home hub and a size weight bootstrapped the same way
+//  - routes are mostly spokes from an airport to its nearest hub, the rest
+//    weight-by-weight (hub-to-hub and point-to-point); each is emitted in
+//    both directions, some with a codeshare copy, and flown by an airline
+//    based at the nearest hub
+//
+// Routes scale without limit. Airport and airline counts default to at most
+// 8x and 10x the bundled data: the route store narrows IDs to 16-bit slots,
+// so more than 65536 airports (or airlines) with routes cannot be loaded.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace datagen {
+
+const double MAX_AIRPORT_SCALE = 8.0;
+const double MAX_AIRLINE_SCALE = 10.0;
+const size_t SLOT_LIMIT = 65536;
+
+struct Options {
+    double scale = 10.0;        // route count multiplier
+    double airportScale = 0.0;  // 0 = min(scale, MAX_AIRPORT_SCALE)
+    double airlineScale = 0.0;  // 0 = min(scale, MAX_AIRLINE_SCALE)
+    double spokeShare = 0.7;    // new routes that join an airport to its nearest hub
+    double codeshareRate = 0.15;
+    uint64_t seed = 42;
+};
+
+struct Summary {
+    size_t airports = 0;
+    size_t airlines = 0;
+    size_t routes = 0;
+};
+
+namespace detail {
+
+inline std::vector<std::string> splitCsv(const std::string& line) {
+    std::vector<std::string> out(1);
+    bool quoted = false;
+    for (char c : line) {
+        if (c == '"') quoted = !quoted;
+        else if (c == ',' && !quoted) out.emplace_back();
+        else out.back().push_back(c);
+    }
+    return out;
+}
+
+inline bool isNull(const std::string& s) { return s.empty() || s == "\\N"; }
+
+inline std::string quote(const std::string& s) { return "\"" + s + "\""; }
+
+// Index into a cumulative weight table.
+class WeightedPick {
+public:
+    void add(double w) { cdf_.push_back((cdf_.empty() ? 0.0 : cdf_.back()) + std::max(w, 0.0)); }
+    bool empty() const { return cdf_.empty() || cdf_.back() <= 0.0; }
+
+    size_t operator()(std::mt19937_64& rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, cdf_.back())(rng);
+        size_t i = std::upper_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+        return std::min(i, cdf_.size() - 1);
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+// Hands out codes of a fixed length over `alphabet` that are not in `used`.
+class CodeAllocator {
+public:
+    CodeAllocator(std::string alphabet, size_t len) : alphabet_(std::move(alphabet)), digits_(len, 0) {}
+
+    void reserve(const std::string& code) { used_.insert(code); }
+
+    // "" once the code space is exhausted
+    std::string next() {
+        while (!done_) {
+            std::string code;
+            for (size_t d : digits_) code.push_back(alphabet_[d]);
+            advance();
+            if (used_.insert(code).second) return code;
+        }
+        return "";
+    }
+
+private:
+    void advance() {
+        for (size_t i = digits_.size(); i-- > 0;) {
+            if (++digits_[i] < alphabet_.size()) return;
+            digits_[i] = 0;
+        }
+        done_ = true;
+    }
+
+    std::string alphabet_;
+    std::vector<size_t> digits_;
+    std::unordered_set<std::string> used_;
+    bool done_ = false;
+};
+
+struct SeedAirport {
+    int id;
+    std::string iata, icao, city, country, dst, tz;
+    double lat, lon;
+    std::string altitude, offset;
+    bool airport;   // type "airport" (not a station or port)
+};
+
+struct SeedAirline {
+    int id;
+    std::string iata, icao, country;
+};
+
+struct GenAirport {
+    int id;
+    std::string code;   // IATA, else ICAO, for route rows
+    std::string country;
+    double lat, lon;
+    double weight;
+};
+
+struct GenAirline {
+    int id;
+    std::string code;
+    double weight;
+};
+
+// Cheap distance for nearest-hub search (equirectangular, squared).
+inline double distance2(double lat1, double lon1, double lat2, double lon2) {
+    const double rad = 3.14159265358979323846 / 180.0;
+    double dLon = std::fabs(lon1 - lon2);
+    if (dLon > 180.0) dLon = 360.0 - dLon;
+    double x = dLon * std::cos((lat1 + lat2) * 0.5 * rad);
+    double y = lat1 - lat2;
+    return x * x + y * y;
+}
+
+} // namespace detail
+
+inline bool generate(const std::string& seedDir, const std::string& outDir, const Options& opt,
+                     Summary* summary, std::string* error) {
+    using namespace detail;
+    auto fail = [error](const std::string& message) {
+        if (error) *error = message;
+        return false;
+    };
+    std::mt19937_64 rng(opt.seed);
+    std::string line;
+
+    // --- seed data ---
+    std::vector<std::string> airportLines, airlineLines, routeLines;
+    std::vector<SeedAirport> seedAirports;
+    std::vector<SeedAirline> seedAirlines;
+    std::unordered_map<int, double> airportDegree, airlineRoutes;
+    std::unordered_map<int, std::unordered_map<int, int>> airlineOrigins;
+    std::vector<std::string> equipment;
+    int maxAirportId = 0, maxAirlineId = 0;
+
+    CodeAllocator airportIata("ABCDEFGHIJKLMNOPQRSTUVWXYZ", 3);
+    CodeAllocator airportIcao("ABCDEFGHIJKLMNOPQRSTUVWXYZ", 4);
+    CodeAllocator airlineIata("ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789", 2);
+    CodeAllocator airlineIcao("ABCDEFGHIJKLMNOPQRSTUVWXYZ", 3);
+
+    {
+        std::ifstream in(seedDir + "/airports.dat");
+        if (!in) return fail("cannot read " + seedDir + "/airports.dat");
+        while (std::getline(in, line)) {
+            auto f = splitCsv(line);
+            if (f.size() < 14 || isNull(f[0])) continue;
+            SeedAirport a;
+            a.id = std::stoi(f[0]);
+            a.city = f[2];
+            a.country = f[3];
+            a.iata = isNull(f[4]) ? "" : f[4];
+            a.icao = isNull(f[5]) ? "" : f[5];
+            a.lat = isNull(f[6]) ? 0.0 : std::stod(f[6]);
+            a.lon = isNull(f[7]) ? 0.0 : std::stod(f[7]);
+            a.altitude = f[8];
+            a.offset = f[9];
+            a.dst = f[10];
+            a.tz = f[11];
+            a.airport = f[12] == "airport";
+            if (!a.iata.empty()) airportIata.reserve(a.iata);
+            if (!a.icao.empty()) airportIcao.reserve(a.icao);
+            maxAirportId = std::max(maxAirportId, a.id);
+            seedAirports.push_back(std::move(a));
+            airportLines.push_back(line);
+        }
+    }
+    {
+        std::ifstream in(seedDir + "/airlines.dat");
+        if (!in) return fail("cannot read " + seedDir + "/airlines.dat");
+        while (std::getline(in, line)) {
+            auto f = splitCsv(line);
+            if (f.size() < 8 || isNull(f[0])) continue;
+            SeedAirline a;
+            a.id = std::stoi(f[0]);
+            a.iata = isNull(f[3]) ? "" : f[3];
+            a.icao = isNull(f[4]) ? "" : f[4];
+            a.country = f[6];
+            if (a.id < 0) continue;
+            if (!a.iata.empty()) airlineIata.reserve(a.iata);
+            if (!a.icao.empty()) airlineIcao.reserve(a.icao);
+            maxAirlineId = std::max(maxAirlineId, a.id);
+            seedAirlines.push_back(std::move(a));
+            airlineLines.push_back(line);
+        }
+    }
+    {
+        std::ifstream in(seedDir + "/routes.dat");
+        if (!in) return fail("cannot read " + seedDir + "/routes.dat");
+        std::unordered_set<std::string> seenEquipment;
+        while (std::getline(in, line)) {
+            auto f = splitCsv(line);
+            if (f.size() < 8 || isNull(f[1]) || isNull(f[3]) || isNull(f[5])) continue;
+            int al = std::stoi(f[1]), src = std::stoi(f[3]), dst = std::stoi(f[5]);
+            airportDegree[src] += 1;
+            airportDegree[dst] += 1;
+            airlineRoutes[al] += 1;
+            ++airlineOrigins[al][src];
+            if (f.size() > 8 && !f[8].empty()) equipment.push_back(f[8]);
+            routeLines.push_back(line);
+        }
+    }
+    if (seedAirports.empty() || seedAirlines.empty() || routeLines.empty()) return fail("seed data is empty");
+    if (equipment.empty()) equipment.push_back("320");
+
+    double airportScale = opt.airportScale > 0 ? opt.airportScale : std::min(opt.scale, MAX_AIRPORT_SCALE);
+    double airlineScale = opt.airlineScale > 0 ? opt.airlineScale : std::min(opt.scale, MAX_AIRLINE_SCALE);
+    size_t airportTarget = static_cast<size_t>(std::max(1.0, airportScale) * seedAirports.size());
+    size_t airlineTarget = static_cast<size_t>(std::max(1.0, airlineScale) * seedAirlines.size());
+    size_t routeTarget = static_cast<size_t>(std::max(1.0, opt.scale) * routeLines.size());
+
+    // --- airports: the bundled ones plus synthetic ones near busy airports ---
+    std::vector<GenAirport> airports;
+    std::vector<double> realDegrees;
+    WeightedPick parentPick;
+    std::vector<size_t> parents;
+    for (const SeedAirport& a : seedAirports) {
+        double degree = 0;
+        auto it = airportDegree.find(a.id);
+        if (it != airportDegree.end()) degree = it->second;
+        std::string code = !a.iata.empty() ? a.iata : a.icao;
+        airports.push_back({ a.id, code, a.country, a.lat, a.lon, a.airport ? degree : 0.0 });
+        if (a.airport && degree > 0) {
+            realDegrees.push_back(degree);
+            parentPick.add(degree);
+            parents.push_back(airports.size() - 1);
+        }
+    }
+    if (parents.empty()) return fail("seed routes reference no airports");
+
+    std::ofstream airportsOut(outDir + "/airports.dat");
+    if (!airportsOut) return fail("cannot write " + outDir + "/airports.dat");
+    for (const std::string& l : airportLines) airportsOut << l << '\n';
+
+    std::normal_distribution<double> jitter(0.0, 1.5);   // degrees
+    std::uniform_int_distribution<size_t> anyDegree(0, realDegrees.size() - 1);
+    int nextAirportId = maxAirportId + 1;
+    for (size_t n = seedAirports.size(); n < airportTarget; ++n) {
+        const SeedAirport& parent = seedAirports[parents[parentPick(rng)]];
+        GenAirport g;
+        g.id = nextAirportId++;
+        g.country = parent.country;
+        g.lat = std::max(-85.0, std::min(85.0, parent.lat + jitter(rng)));
+        g.lon = parent.lon + jitter(rng);
+        if (g.lon > 180.0) g.lon -= 360.0;
+        if (g.lon < -180.0) g.lon += 360.0;
+        g.weight = realDegrees[anyDegree(rng)] * std::uniform_real_distribution<double>(0.5, 1.5)(rng);
+        std::string iata = airportIata.next();
+        std::string icao = airportIcao.next();
+        g.code = !iata.empty() ? iata : icao;
+        char coords[64];
+        std::snprintf(coords, sizeof(coords), "%.6f,%.6f", g.lat, g.lon);
+        airportsOut << g.id << ',' << quote("Synthetic Airport " + std::to_string(g.id)) << ','
+                    << quote(parent.city) << ',' << quote(parent.country) << ','
+                    << (iata.empty() ? "\\N" : quote(iata)) << ',' << (icao.empty() ? "\\N" : quote(icao)) << ','
+                    << coords << ',' << parent.altitude << ',' << parent.offset << ',' << quote(parent.dst) << ','
+                    << quote(parent.tz) << ",\"airport\",\"Synthetic\"\n";
+        airports.push_back(std::move(g));
+    }
+    airportsOut.close();
+
+    // --- hubs: the heaviest airports; every airport's nearest hub ---
+    std::vector<size_t> byWeight(airports.size());
+    for (size_t i = 0; i < byWeight.size(); ++i) byWeight[i] = i;
+    std::sort(byWeight.begin(), byWeight.end(),
+              [&airports](size_t a, size_t b) { return airports[a].weight > airports[b].weight; });
+    size_t hubCount = std::min<size_t>(512, std::max<size_t>(20, airports.size() / 50));
+    std::vector<size_t> hubs(byWeight.begin(), byWeight.begin() + std::min(hubCount, byWeight.size()));
+    std::vector<int> hubIndexOf(airports.size(), -1);
+    for (size_t h = 0; h < hubs.size(); ++h) hubIndexOf[hubs[h]] = static_cast<int>(h);
+
+    std::vector<uint32_t> nearestHub(airports.size());
+    for (size_t i = 0; i < airports.size(); ++i) {
+        double best = 1e300;
+        for (size_t h = 0; h < hubs.size(); ++h) {
+            if (hubs[h] == i) continue;
+            double d = distance2(airports[i].lat, airports[i].lon, airports[hubs[h]].lat, airports[hubs[h]].lon);
+            if (d < best) {
+                best = d;
+                nearestHub[i] = static_cast<uint32_t>(h);
+            }
+        }
+    }
+
+    WeightedPick airportPick, hubPick;
+    for (const GenAirport& a : airports) airportPick.add(a.weight);
+    for (size_t h : hubs) hubPick.add(airports[h].weight);
+
+    // --- airlines: the bundled ones plus synthetic ones, each based at a hub ---
+    std::unordered_map<int, size_t> airportIndex;
+    for (size_t i = 0; i < airports.size(); ++i) airportIndex[airports[i].id] = i;
+
+    std::vector<GenAirline> airlines;
+    std::vector<std::vector<size_t>> airlinesAtHub(hubs.size());
+    std::vector<double> realSizes;
+    for (const SeedAirline& a : seedAirlines) {
+        double size = 0;
+        auto it = airlineRoutes.find(a.id);
+        if (it != airlineRoutes.end()) size = it->second;
+        std::string code = !a.iata.empty() ? a.iata : a.icao;
+        airlines.push_back({ a.id, code, size });
+        if (size <= 0) continue;
+        realSizes.push_back(size);
+        // based at the hub nearest its busiest origin
+        int origin = -1, most = 0;
+        for (const auto& kv : airlineOrigins[a.id]) {
+            if (kv.second > most) {
+                most = kv.second;
+                origin = kv.first;
+            }
+        }
+        auto ai = airportIndex.find(origin);
+        if (ai != airportIndex.end()) {
+            size_t home = hubIndexOf[ai->second] >= 0 ? hubIndexOf[ai->second] : nearestHub[ai->second];
+            airlinesAtHub[home].push_back(airlines.size() - 1);
+        }
+    }
+
+    std::ofstream airlinesOut(outDir + "/airlines.dat");
+    if (!airlinesOut) return fail("cannot write " + outDir + "/airlines.dat");
+    for (const std::string& l : airlineLines) airlinesOut << l << '\n';
+    std::uniform_int_distribution<size_t> anySize(0, realSizes.size() - 1);
+    int nextAirlineId = maxAirlineId + 1;
+    for (size_t n = seedAirlines.size(); n < airlineTarget; ++n) {
+        size_t home = hubPick(rng);
+        GenAirline g;
+        g.id = nextAirlineId++;
+        g.weight = realSizes[anySize(rng)] * std::uniform_real_distribution<double>(0.5, 1.5)(rng);
+        std::string iata = airlineIata.next();
+        std::string icao = airlineIcao.next();
+        g.code = !iata.empty() ? iata : icao;
+        airlinesOut << g.id << ',' << quote("Synthetic Airline " + std::to_string(g.id)) << ",\\N,"
+                    << (iata.empty() ? "\\N" : quote(iata)) << ',' << (icao.empty() ? "\\N" : quote(icao)) << ','
+                    << quote("SYNTH" + std::to_string(g.id)) << ',' << quote(airports[hubs[home]].country) << ",\"Y\"\n";
+        airlinesAtHub[home].push_back(airlines.size());
+        airlines.push_back(std::move(g));
+    }
+    airlinesOut.close();
+
+    std::vector<WeightedPick> hubAirlinePick(hubs.size());
+    for (size_t h = 0; h < hubs.size(); ++h) {
+        for (size_t a : airlinesAtHub[h]) hubAirlinePick[h].add(airlines[a].weight);
+    }
+    WeightedPick anyAirlinePick;
+    for (const GenAirline& a : airlines) anyAirlinePick.add(a.weight);
+
+    // --- routes: the bundled ones, then hub-and-spoke growth ---
+    std::ofstream routesOut(outDir + "/routes.dat");
+    if (!routesOut) return fail("cannot write " + outDir + "/routes.dat");
+    for (const std::string& l : routeLines) routesOut << l << '\n';
+    size_t routeCount = routeLines.size();
+
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<size_t> anyEquipment(0, equipment.size() - 1);
+    auto hubOf = [&](size_t i) { return hubIndexOf[i] >= 0 ? static_cast<size_t>(hubIndexOf[i]) : nearestHub[i]; };
+    auto pickAirline = [&](size_t hub) {
+        const WeightedPick& local = hubAirlinePick[hub];
+        if (!local.empty() && unit(rng) < 0.9) return airlinesAtHub[hub][local(rng)];
+        return anyAirlinePick(rng);
+    };
+    auto emit = [&](size_t al, size_t src, size_t dst, bool codeshare, const std::string& equip) {
+        routesOut << airlines[al].code << ',' << airlines[al].id << ',' << airports[src].code << ','
+                  << airports[src].id << ',' << airports[dst].code << ',' << airports[dst].id << ','
+                  << (codeshare ? "Y" : "") << ",0," << equip << '\n';
+        ++routeCount;
+    };
+
+    while (routeCount < routeTarget) {
+        size_t src = airportPick(rng);
+        size_t dst = unit(rng) < opt.spokeShare ? hubs[nearestHub[src]] : airportPick(rng);
+        if (dst == src) continue;
+        size_t hub = hubOf(unit(rng) < 0.5 ? src : dst);
+        size_t al = pickAirline(hub);
+        const std::string& equip = equipment[anyEquipment(rng)];
+        emit(al, src, dst, false, equip);
+        emit(al, dst, src, false, equip);
+        if (unit(rng) < opt.codeshareRate) {
+            size_t partner = pickAirline(hub);
+            if (partner != al) {
+                emit(partner, src, dst, true, equip);
+                emit(partner, dst, src, true, equip);
+            }
+        }
+    }
+    routesOut.close();
+    if (!routesOut) return fail("error writing " + outDir + "/routes.dat");
+
+    if (summary) {
+        summary->airports = airports.size();
+        summary->airlines = airlines.size();
+        summary->routes = routeCount;
+    }
+    if (error && (airports.size() > SLOT_LIMIT || airlines.size() > SLOT_LIMIT)) {
+        *error = "more than 65536 airports or airlines; the server will skip routes past its slot limit";
+    }
+    return true;
+}
+
+} // namespace datagen
@@ -0,0 +1,554 @@
+// HTTP load generator for the server. Drives a weighted mix of endpoints
+// from N keep-alive connections (one thread each, closed loop) and reports
+// throughput and latency percentiles per request class. Standalone: plain
+// POSIX sockets, no Crow.
+//
+//   g++ bench/loadgen.cpp -std=c++17 -O2 -pthread -o loadgen
+//   ./loadgen --port 8080 --concurrency 16 --duration 30 --zipf 1.1
+//             --mix lookup=50,onehop=20,reports=25,mutation=5
+//
+// Airports and airlines are drawn from a Zipf distribution over their rank
+// by route count in the .dat files (--data), so hubs are the hot keys.
+// Mutations insert a route that is not in routes.dat and then delete it, so
+// the dataset is unchanged after a run.
+//
+// --record FILE writes every issued request, in issue order, as
+//   class<TAB>method<TAB>path<TAB>body
+// and --replay FILE sends exactly those requests in the same order (one
+// pass; use --concurrency 1 for a strictly serial replay) to compare builds.
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// ---------- Options ----------
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    int concurrency = 8;
+    double durationSec = 10.0;
+    long maxRequests = 0;           // operations; 0 = run for durationSec
+    std::string mix = "lookup=50,onehop=20,reports=25,mutation=5";
+    double zipf = 1.1;
+    uint64_t seed = 1;
+    std::string dataDir = ".";
+    std::string recordPath;
+    std::string replayPath;
+    bool json = false;
+};
+
+void usage() {
+    std::cerr <<
+        "usage: loadgen [--host H] [--port P] [--concurrency N] [--duration SEC | --requests N]\n"
+        "               [--mix lookup=50,onehop=20,reports=25,mutation=5] [--zipf S] [--seed N]\n"
+        "               [--data DIR] [--record FILE | --replay FILE] [--json]\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char* v = nullptr;
+        if (arg == "--json") { o.json = true; continue; }
+        if (arg == "--help" || arg == "-h") return false;
+        if (!(v = next())) return false;
+        if (arg == "--host") o.host = v;
+        else if (arg == "--port") o.port = std::atoi(v);
+        else if (arg == "--concurrency") o.concurrency = std::max(1, std::atoi(v));
+        else if (arg == "--duration") o.durationSec = std::atof(v);
+        else if (arg == "--requests") o.maxRequests = std::atol(v);
+        else if (arg == "--mix") o.mix = v;
+        else if (arg == "--zipf") o.zipf = std::atof(v);
+        else if (arg == "--seed") o.seed = std::strtoull(v, nullptr, 10);
+        else if (arg == "--data") o.dataDir = v;
+        else if (arg == "--record") o.recordPath = v;
+        else if (arg == "--replay") o.replayPath = v;
+        else return false;
+    }
+    return true;
+}
+
+// ---------- Traffic Model ----------
+
+struct Request {
+    std::string cls;
+    std::string method;
+    std::string path;
+    std::string body;
+};
+
+// Minimal quoted-CSV split, enough for the OpenFlights files.
+std::vector<std::string> splitCsv(const std::string& line) {
+    std::vector<std::string> out(1);
+    bool quoted = false;
+    for (char c : line) {
+        if (c == '"') quoted = !quoted;
+        else if (c == ',' && !quoted) out.emplace_back();
+        else out.back().push_back(c);
+    }
+    return out;
+}
+
+struct Entity {
+    std::string code;
+    int id;
+    int routes;
+};
+
+struct Dataset {
+    std::vector<Entity> airports;   // by route count, descending
+    std::vector<Entity> airlines;
+    std::set<std::tuple<int, int, int>> existing;
+};
+
+bool loadDataset(const std::string& dir, Dataset& d) {
+    std::unordered_map<int, int> airportDegree, airlineDegree;
+    std::ifstream routesIn(dir + "/routes.dat");
+    if (!routesIn) return false;
+    std::string line;
+    while (std::getline(routesIn, line)) {
+        auto f = splitCsv(line);
+        if (f.size() < 8 || f[1] == "\\N" || f[3] == "\\N" || f[5] == "\\N") continue;
+        int al = std::atoi(f[1].c_str()), src = std::atoi(f[3].c_str()), dst = std::atoi(f[5].c_str());
+        ++airlineDegree[al];
+        ++airportDegree[src];
+        ++airportDegree[dst];
+        d.existing.emplace(al, src, dst);
+    }
+
+    auto load = [&line](const std::string& path, size_t codeField, size_t codeLen,
+                        std::unordered_map<int, int>& degree, std::vector<Entity>& out) {
+        std::ifstream in(path);
+        if (!in) return false;
+        while (std::getline(in, line)) {
+            auto f = splitCsv(line);
+            if (f.size() <= codeField || f[codeField].size() != codeLen) continue;
+            int id = std::atoi(f[0].c_str());
+            auto it = degree.find(id);
+            if (it == degree.end()) continue;
+            out.push_back({ f[codeField], id, it->second });
+        }
+        std::sort(out.begin(), out.end(), [](const Entity& a, const Entity& b) {
+            return a.routes != b.routes ? a.routes > b.routes : a.code < b.code;
+        });
+        return !out.empty();
+    };
+    return load(dir + "/airports.dat", 4, 3, airportDegree, d.airports) &&
+           load(dir + "/airlines.dat", 3, 2, airlineDegree, d.airlines);
+}
+
+// Samples ranks 0..n-1 with P(k) proportional to 1 / (k + 1)^s.
+class ZipfSampler {
+public:
+    ZipfSampler(size_t n, double s) : cdf_(n) {
+        double sum = 0;
+        for (size_t k = 0; k < n; ++k) {
+            sum += 1.0 / std::pow(static_cast<double>(k + 1), s);
+            cdf_[k] = sum;
+        }
+        for (double& c : cdf_) c /= sum;
+    }
+
+    size_t operator()(std::mt19937_64& rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        size_t k = std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+        return std::min(k, cdf_.size() - 1);
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+const char* const CLASSES[] = { "lookup", "onehop", "reports", "mutation" };
+const int CLASS_COUNT = 4;
+
+class TrafficModel {
+public:
+    TrafficModel(const Dataset& d, double zipf, const std::vector<double>& weights)
+        : d_(d), airportRank_(d.airports.size(), zipf), airlineRank_(d.airlines.size(), zipf),
+          classCdf_(weights.size()) {
+        double sum = 0;
+        for (size_t c = 0; c < weights.size(); ++c) classCdf_[c] = sum += weights[c];
+        for (double& c : classCdf_) c /= sum;
+    }
+
+    // One logical operation; mutations are an insert followed by a delete.
+    std::vector<Request> next(std::mt19937_64& rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        int cls = static_cast<int>(std::upper_bound(classCdf_.begin(), classCdf_.end() - 1, u) - classCdf_.begin());
+        std::string name = CLASSES[cls];
+        auto pick = [&rng](int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); };
+        switch (cls) {
+        case 0: {
+            int kind = pick(3);
+            if (kind == 0) return { { name, "GET", "/airport/" + airport(rng).code, "" } };
+            if (kind == 1) return { { name, "GET", "/airline/" + airline(rng).code, "" } };
+            return { { name, "GET", "/distance/" + airport(rng).code + "/" + airport(rng).code, "" } };
+        }
+        case 1:
+            return { { name, "GET", "/onehop/" + airport(rng).code + "/" + airport(rng).code, "" } };
+        case 2: {
+            int kind = pick(4);
+            if (kind == 0) return { { name, "GET", "/reports/airlineRoutes/" + airline(rng).code, "" } };
+            if (kind == 1) return { { name, "GET", "/reports/airportRoutes/" + airport(rng).code, "" } };
+            if (kind == 2) return { { name, "GET", "/topCitiesForAirline/" + airline(rng).code + "?n=5", "" } };
+            return { { name, "GET", "/airlinesForAirport/" + airport(rng).code, "" } };
+        }
+        default: {
+            // a (airline, src, dst) triple not in the bundled data, so the
+            // delete only removes what the insert added
+            const Entity* al;
+            const Entity* src;
+            const Entity* dst;
+            do {
+                al = &airline(rng);
+                src = &airport(rng);
+                dst = &airport(rng);
+            } while (src == dst || d_.existing.count({ al->id, src->id, dst->id }));
+            std::string body = "{\"airlineId\":" + std::to_string(al->id) +
+                               ",\"srcAirportId\":" + std::to_string(src->id) +
+                               ",\"dstAirportId\":" + std::to_string(dst->id) + "}";
+            return { { name, "POST", "/route", body }, { name, "DELETE", "/route", body } };
+        }
+        }
+    }
+
+private:
+    const Entity& airport(std::mt19937_64& rng) const { return d_.airports[airportRank_(rng)]; }
+    const Entity& airline(std::mt19937_64& rng) const { return d_.airlines[airlineRank_(rng)]; }
+
+    const Dataset& d_;
+    ZipfSampler airportRank_;
+    ZipfSampler airlineRank_;
+    std::vector<double> classCdf_;
+};
+
+bool parseMix(const std::string& mix, std::vector<double>& weights) {
+    weights.assign(CLASS_COUNT, 0.0);
+    std::stringstream ss(mix);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        std::string name = item.substr(0, eq);
+        int cls = -1;
+        for (int c = 0; c < CLASS_COUNT; ++c) {
+            if (name == CLASSES[c]) cls = c;
+        }
+        if (cls < 0) return false;
+        weights[cls] = std::max(0.0, std::atof(item.c_str() + eq + 1));
+    }
+    for (double w : weights) {
+        if (w > 0) return true;
+    }
+    return false;
+}
+
+// ---------- Record / Replay ----------
+
+class Recorder {
+public:
+    bool open(const std::string& path) {
+        out_.open(path, std::ios::trunc);
+        return static_cast<bool>(out_);
+    }
+    bool enabled() const { return out_.is_open(); }
+
+    void write(const std::vector<Request>& batch) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Request& r : batch) {
+            out_ << r.cls << '\t' << r.method << '\t' << r.path << '\t' << r.body << '\n';
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::ofstream out_;
+};
+
+bool loadReplay(const std::string& path, std::vector<Request>& out) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        Request r;
+        std::stringstream ss(line);
+        if (!std::getline(ss, r.cls, '\t') || !std::getline(ss, r.method, '\t') ||
+            !std::getline(ss, r.path, '\t')) {
+            continue;
+        }
+        std::getline(ss, r.body);
+        out.push_back(std::move(r));
+    }
+    return true;
+}
+
+// ---------- HTTP Client ----------
+
+// One keep-alive connection; reconnects after any transport error.
+class Connection {
+public:
+    Connection(const Options& o) : host_(o.host), port_(o.port) {}
+    ~Connection() { close(); }
+
+    // HTTP status, or -1 on a transport error
+    int send(const Request& r) {
+        if (fd_ < 0 && !connect()) return -1;
+        std::string msg = r.method + " " + r.path + " HTTP/1.1\r\nHost: " + host_ +
+                          "\r\nConnection: keep-alive\r\n";
+        if (!r.body.empty()) {
+            msg += "Content-Type: application/json\r\nContent-Length: " + std::to_string(r.body.size()) + "\r\n";
+        }
+        msg += "\r\n" + r.body;
+        if (!writeAll(msg)) return fail();
+        return readResponse();
+    }
+
+private:
+    bool connect() {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res = nullptr;
+        if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &res) != 0) return false;
+        for (addrinfo* a = res; a; a = a->ai_next) {
+            int fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd < 0) continue;
+            if (::connect(fd, a->ai_addr, a->ai_addrlen) == 0) {
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                fd_ = fd;
+                break;
+            }
+            ::close(fd);
+        }
+        freeaddrinfo(res);
+        buf_.clear();
+        return fd_ >= 0;
+    }
+
+    void close() {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+    }
+
+    int fail() {
+        close();
+        return -1;
+    }
+
+    bool writeAll(const std::string& s) {
+        size_t off = 0;
+        while (off < s.size()) {
+            ssize_t n = ::send(fd_, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            off += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool fill() {
+        char chunk[16384];
+        ssize_t n = ::recv(fd_, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buf_.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    int readResponse() {
+        size_t headerEnd;
+        while ((headerEnd = buf_.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill()) return fail();
+        }
+        std::string headers = buf_.substr(0, headerEnd);
+        int status = 0;
+        if (std::sscanf(headers.c_str(), "HTTP/%*d.%*d %d", &status) != 1) return fail();
+
+        std::string lower = headers;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        size_t length = 0;
+        size_t cl = lower.find("\r\ncontent-length:");
+        if (cl != std::string::npos) length = std::strtoul(lower.c_str() + cl + 17, nullptr, 10);
+        bool closeAfter = lower.find("\r\nconnection: close") != std::string::npos;
+
+        size_t total = headerEnd + 4 + length;
+        while (buf_.size() < total) {
+            if (!fill()) return fail();
+        }
+        buf_.erase(0, total);
+        if (closeAfter) close();
+        return status;
+    }
+
+    std::string host_;
+    int port_;
+    int fd_ = -1;
+    std::string buf_;
+};
+
+// ---------- Stats ----------
+
+struct ClassStats {
+    std::vector<uint32_t> micros;
+    long errors = 0;
+};
+
+using StatsByClass = std::map<std::string, ClassStats>;
+
+double percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t idx = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, idx == 0 ? 0 : idx - 1)] / 1000.0;
+}
+
+void report(const StatsByClass& byClass, double seconds, bool json) {
+    const double ps[] = { 50, 90, 99, 99.9 };
+    StatsByClass rows = byClass;
+    ClassStats& all = rows["total"];
+    for (const auto& kv : byClass) {
+        all.micros.insert(all.micros.end(), kv.second.micros.begin(), kv.second.micros.end());
+        all.errors += kv.second.errors;
+    }
+    for (auto& kv : rows) std::sort(kv.second.micros.begin(), kv.second.micros.end());
+
+    if (json) {
+        std::printf("{\"seconds\":%.3f,\"classes\":{", seconds);
+        bool first = true;
+        for (const auto& kv : rows) {
+            const auto& m = kv.second.micros;
+            std::printf("%s\"%s\":{\"requests\":%zu,\"errors\":%ld,\"rps\":%.1f,\"p50_ms\":%.3f,"
+                        "\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"p999_ms\":%.3f,\"max_ms\":%.3f}",
+                        first ? "" : ",", kv.first.c_str(), m.size(), kv.second.errors, m.size() / seconds,
+                        percentile(m, ps[0]), percentile(m, ps[1]), percentile(m, ps[2]), percentile(m, ps[3]),
+                        m.empty() ? 0.0 : m.back() / 1000.0);
+            first = false;
+        }
+        std::printf("}}\n");
+        return;
+    }
+
+    std::printf("%-10s %10s %8s %10s %9s %9s %9s %9s %9s\n", "class", "requests", "errors", "req/s",
+                "p50 ms", "p90 ms", "p99 ms", "p99.9 ms", "max ms");
+    for (const auto& kv : rows) {
+        const auto& m = kv.second.micros;
+        std::printf("%-10s %10zu %8ld %10.1f %9.3f %9.3f %9.3f %9.3f %9.3f\n", kv.first.c_str(), m.size(),
+                    kv.second.errors, m.size() / seconds, percentile(m, ps[0]), percentile(m, ps[1]),
+                    percentile(m, ps[2]), percentile(m, ps[3]), m.empty() ? 0.0 : m.back() / 1000.0);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parseOptions(argc, argv, o)) {
+        usage();
+        return 2;
+    }
+
+    std::vector<Request> replay;
+    Dataset data;
+    std::unique_ptr<TrafficModel> model;
+    if (!o.replayPath.empty()) {
+        if (!loadReplay(o.replayPath, replay)) {
+            std::cerr << "Failed to read replay file: " << o.replayPath << "\n";
+            return 1;
+        }
+    } else {
+        std::vector<double> weights;
+        if (!parseMix(o.mix, weights)) {
+            std::cerr << "Bad --mix (classes: lookup, onehop, reports, mutation)\n";
+            return 2;
+        }
+        if (!loadDataset(o.dataDir, data)) {
+            std::cerr << "Failed to read .dat files from " << o.dataDir << "\n";
+            return 1;
+        }
+        model.reset(new TrafficModel(data, o.zipf, weights));
+    }
+
+    Recorder recorder;
+    if (!o.recordPath.empty() && !recorder.open(o.recordPath)) {
+        std::cerr << "Failed to open record file: " << o.recordPath << "\n";
+        return 1;
+    }
+
+    std::atomic<long> issued{0};
+    std::atomic<size_t> replayNext{0};
+    std::vector<StatsByClass> perThread(o.concurrency);
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point deadline =
+        start + std::chrono::microseconds(static_cast<long long>(o.durationSec * 1e6));
+
+    auto worker = [&](int t) {
+        Connection conn(o);
+        std::mt19937_64 rng(o.seed * 1000003 + static_cast<uint64_t>(t));
+        StatsByClass& stats = perThread[t];
+        for (;;) {
+            std::vector<Request> batch;
+            if (model) {
+                if (o.maxRequests > 0 ? issued.fetch_add(1) >= o.maxRequests : Clock::now() >= deadline) break;
+                batch = model->next(rng);
+                if (recorder.enabled()) recorder.write(batch);
+            } else {
+                size_t i = replayNext.fetch_add(1);
+                if (i >= replay.size()) break;
+                batch.push_back(replay[i]);
+            }
+            for (const Request& r : batch) {
+                Clock::time_point t0 = Clock::now();
+                int status = conn.send(r);
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count();
+                ClassStats& cs = stats[r.cls];
+                cs.micros.push_back(static_cast<uint32_t>(std::min<long long>(us, UINT32_MAX)));
+                if (status < 200 || status >= 300) ++cs.errors;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < o.concurrency; ++t) threads.emplace_back(worker, t);
+    for (auto& th : threads) th.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    StatsByClass merged;
+    for (auto& s : perThread) {
+        for (auto& kv : s) {
+            ClassStats& m = merged[kv.first];
+            m.micros.insert(m.micros.end(), kv.second.micros.begin(), kv.second.micros.end());
+            m.errors += kv.second.errors;
+        }
+    }
+    report(merged, seconds, o.json);
+    return 0;
+}
@@ -0,0 +1,29 @@
+#!/bin/sh
+# Runs the query benchmarks over generated datasets of increasing size and
+# charts per-endpoint latency against route count (airports and airlines stop
+# growing at 8x and 10x, see bench/datagen.h), then does the same for
+# the analytics kernels (isochrone, components, hop matrix, centrality) over
+# smaller scales, since the hop matrix needs n^2 / 2 bytes.
+#
+#   bench/scaling.sh [scales] [out-prefix] [kernel-scales]
+#                                     # defaults: 1,10,100 scaling 1,2,4
+#
+# Writes <out-prefix>.json (Google Benchmark), <out-prefix>.csv and
+# <out-prefix>.svg, plus <out-prefix>-kernels.{json,csv,svg}. Run from the
+# repo root; needs make, g++, libbenchmark, python3.
+set -e
+
+SCALES=${1:-1,10,100}
+OUT=${2:-scaling}
+KERNEL_SCALES=${3:-1,2,4}
+
+make bench_app
+BENCH_SCALES="$SCALES" ./bench_app \
+    --benchmark_filter='BM_(AirlinesForAirport|TopDestinations|Distance|AirlinesReport|AirportsReport|AirlineRoutesReport|AirportRoutesReport|OneHop|GetAirportByIata)' \
+    --benchmark_out="$OUT.json" --benchmark_out_format=json
+python3 bench/scaling_chart.py "$OUT.json" "$OUT"
+
+BENCH_SCALES="$KERNEL_SCALES" ./bench_app \
+    --benchmark_filter='BM_(Isochrone|Components|HopMatrix|Centrality)' \
+    --benchmark_out="$OUT-kernels.json" --benchmark_out_format=json
+python3 bench/scaling_chart.py "$OUT-kernels.json" "$OUT-kernels"
@@ -0,0 +1,108 @@
+"""Turns a Google Benchmark JSON file from bench/scaling.sh into a CSV table
+and an SVG line chart of latency against route count, one line per
+benchmark (log-log). Standard library only.
+
+The x axis is route count only. bench/datagen.h caps airports and airlines
+at 8x and 10x the bundled data (the route store's 16-bit slot limit), so
+past those scales only routes grow; each tick also shows the airport count.
+
+usage: python3 bench/scaling_chart.py scaling.json OUT_PREFIX
+"""
+import json
+import math
+import sys
+from collections import defaultdict
+
+WIDTH, HEIGHT = 900, 560
+LEFT, RIGHT, TOP, BOTTOM = 80, 260, 30, 60
+COLORS = ["#1f77b4", "#ff7f0e", "#2ca02c", "#d62728", "#9467bd", "#8c564b",
+          "#e377c2", "#7f7f7f", "#bcbd22", "#17becf", "#393b79", "#637939"]
+UNIT_MS = {"ns": 1e-6, "us": 1e-3, "ms": 1.0, "s": 1e3}
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    series = defaultdict(list)
+    for b in data["benchmarks"]:
+        if b.get("run_type") == "aggregate" or "/scale:" not in b["name"]:
+            continue
+        name, _, scale = b["name"].rpartition("/scale:")
+        scale = scale.split("/")[0]  # drop /real_time and similar suffixes
+        ms = b["real_time"] * UNIT_MS[b.get("time_unit", "ns")]
+        series[name].append((int(scale), b.get("routes", 0), ms,
+                             b.get("airports", 0), b.get("airlines", 0)))
+    for points in series.values():
+        points.sort()
+    return series
+
+
+def write_csv(series, path):
+    with open(path, "w") as f:
+        f.write("benchmark,scale,routes,airports,airlines,ms\n")
+        for name in sorted(series):
+            for scale, routes, ms, airports, airlines in series[name]:
+                f.write(f"{name},{scale},{int(routes)},{int(airports)},{int(airlines)},{ms:.6f}\n")
+
+
+def write_svg(series, path):
+    points = [p for s in series.values() for p in s if p[1] > 0 and p[2] > 0]
+    if not points:
+        raise SystemExit("no scaled benchmarks in input")
+    x0, x1 = math.log10(min(p[1] for p in points)), math.log10(max(p[1] for p in points))
+    y0, y1 = math.floor(math.log10(min(p[2] for p in points))), math.ceil(math.log10(max(p[2] for p in points)))
+    if x1 == x0:
+        x1 = x0 + 1
+    plot_w, plot_h = WIDTH - LEFT - RIGHT, HEIGHT - TOP - BOTTOM
+
+    def px(routes):
+        return LEFT + (math.log10(routes) - x0) / (x1 - x0) * plot_w
+
+    def py(ms):
+        return TOP + (y1 - math.log10(ms)) / (y1 - y0) * plot_h
+
+    out = [f'<svg xmlns="http://www.w3.org/2000/svg" width="{WIDTH}" height="{HEIGHT}" '
+           f'font-family="sans-serif" font-size="12">',
+           f'<rect width="{WIDTH}" height="{HEIGHT}" fill="white"/>']
+    for e in range(y0, y1 + 1):
+        y = py(10 ** e)
+        out.append(f'<line x1="{LEFT}" y1="{y:.1f}" x2="{LEFT + plot_w}" y2="{y:.1f}" stroke="#ddd"/>')
+        out.append(f'<text x="{LEFT - 8}" y="{y + 4:.1f}" text-anchor="end">{10 ** e:g} ms</text>')
+    airports_at = {p[1]: p[3] for p in points}
+    for routes in sorted(airports_at):
+        x = px(routes)
+        out.append(f'<line x1="{x:.1f}" y1="{TOP}" x2="{x:.1f}" y2="{TOP + plot_h}" stroke="#eee"/>')
+        out.append(f'<text x="{x:.1f}" y="{TOP + plot_h + 16}" text-anchor="middle">{int(routes):,}</text>')
+        out.append(f'<text x="{x:.1f}" y="{TOP + plot_h + 30}" text-anchor="middle" fill="#777">'
+                   f'{int(airports_at[routes]):,} airports</text>')
+    out.append(f'<text x="{LEFT + plot_w / 2}" y="{HEIGHT - 10}" text-anchor="middle">'
+               'route count (airports stop growing at 8x, airlines at 10x: 16-bit slot limit)</text>')
+
+    for i, name in enumerate(sorted(series)):
+        color = COLORS[i % len(COLORS)]
+        pts = [(px(r), py(ms)) for _, r, ms, _, _ in series[name] if r > 0 and ms > 0]
+        if not pts:
+            continue
+        out.append('<polyline fill="none" stroke="%s" stroke-width="2" points="%s"/>'
+                   % (color, " ".join(f"{x:.1f},{y:.1f}" for x, y in pts)))
+        for x, y in pts:
+            out.append(f'<circle cx="{x:.1f}" cy="{y:.1f}" r="3" fill="{color}"/>')
+        ly = TOP + 10 + i * 18
+        out.append(f'<rect x="{WIDTH - RIGHT + 15}" y="{ly - 9}" width="12" height="12" fill="{color}"/>')
+        out.append(f'<text x="{WIDTH - RIGHT + 32}" y="{ly + 1}">{name.removeprefix("BM_")}</text>')
+    out.append("</svg>")
+    with open(path, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit(__doc__)
+    series = load(sys.argv[1])
+    write_csv(series, sys.argv[2] + ".csv")
+    write_svg(series, sys.argv[2] + ".svg")
+    print(f"wrote {sys.argv[2]}.csv and {sys.argv[2]}.svg ({len(series)} benchmarks)")
+
+
+if __name__ == "__main__":
+    main()
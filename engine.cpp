@@ -0,0 +1,3305 @@
+// Definitions for engine.h: loaders, indexes, background analytics and the
+// query and mutation functions.
+
+#include "engine.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// ---------- Global Storage ----------
+
+Dataset liveDataset;
+
+StringPool& strings = liveDataset.strings;
+std::unordered_map<int, Airline>& airlinesById = liveDataset.airlinesById;
+std::unordered_map<std::string, Airline*>& airlinesByIata = liveDataset.airlinesByIata;
+std::unordered_map<uint32_t, Airline*>& airlinesByIcao = liveDataset.airlinesByIcao;
+std::unordered_map<int, Airport>& airportsById = liveDataset.airportsById;
+std::unordered_map<std::string, Airport*>& airportsByIata = liveDataset.airportsByIata;
+std::unordered_map<uint32_t, Airport*>& airportsByIcao = liveDataset.airportsByIcao;
+RouteStore& routes = liveDataset.routes;
+DenseIndex& airportSlots = liveDataset.routes.airportSlots;
+DenseIndex& airlineSlots = liveDataset.routes.airlineSlots;
+
+void swap(Dataset& a, Dataset& b) {
+    std::swap(a.strings, b.strings);
+    a.airlinesById.swap(b.airlinesById);
+    a.airlinesByIata.swap(b.airlinesByIata);
+    a.airlinesByIcao.swap(b.airlinesByIcao);
+    a.airportsById.swap(b.airportsById);
+    a.airportsByIata.swap(b.airportsByIata);
+    a.airportsByIcao.swap(b.airportsByIcao);
+    std::swap(a.routes, b.routes);
+}
+
+// ---------- Dataset Versioning ----------
+
+// Readers take a shared lock, mutations take a unique lock and bump the
+// version so derived indexes know they are out of date.
+std::shared_mutex dataMutex;
+std::atomic<uint64_t> datasetVersion{1};
+std::mutex reloadMutex;                  // one load at a time
+
+std::mutex analyticsMutex;
+std::condition_variable analyticsCv;
+
+void markDatasetChanged() {
+    {
+        std::lock_guard<std::mutex> lk(analyticsMutex);
+        datasetVersion.fetch_add(1);
+    }
+    analyticsCv.notify_all();
+}
+
+// ---------- Engine Options ----------
+
+// Copies of EngineOptions, read on the hot paths without a lock.
+std::atomic<bool> graphAirportsOnly{false};
+std::atomic<bool> hopMatrixEnabled{false};
+std::atomic<bool> centralityEnabled{false};
+std::atomic<unsigned> analyticsThreads{0};
+
+void setEngineOptions(const EngineOptions& options) {
+    // not while a load or a mutation is building indexes with the old scope
+    std::lock_guard<std::mutex> serial(reloadMutex);
+    std::unique_lock<std::shared_mutex> lock(dataMutex);
+    graphAirportsOnly = options.graphAirportsOnly;
+    hopMatrixEnabled = options.hopMatrix;
+    centralityEnabled = options.centrality;
+    analyticsThreads = options.analyticsThreads;
+}
+
+EngineOptions engineOptions() {
+    EngineOptions options;
+    options.graphAirportsOnly = graphAirportsOnly;
+    options.hopMatrix = hopMatrixEnabled;
+    options.centrality = centralityEnabled;
+    options.analyticsThreads = analyticsThreads;
+    return options;
+}
+
+bool envEnabled(const char* name, bool fallback) {
+    const char* env = std::getenv(name);
+    if (!env) return fallback;
+    std::string v(env);
+    return !(v == "0" || v == "false" || v == "off" || v == "no");
+}
+
+// ---------- Tracing ----------
+
+std::atomic<bool> tracingEnabled{false};
+
+// One fixed ring per thread, registered on first use; see TraceSpan.
+struct TraceEvent {
+    const char* name;     // static string
+    uint64_t startNs;     // since traceOrigin
+    uint64_t durNs;
+};
+
+struct TraceRing {
+    uint32_t tid = 0;
+    std::atomic<uint64_t> head{0};       // events ever written
+    std::atomic<uint64_t> floor{0};      // events before this were cleared
+    TraceEvent events[TRACE_RING_EVENTS];
+};
+
+std::mutex traceRingsMutex;
+std::vector<std::unique_ptr<TraceRing>> traceRings;
+
+// trace timestamps count from process start
+const std::chrono::steady_clock::time_point traceOrigin = std::chrono::steady_clock::now();
+
+uint64_t traceNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - traceOrigin).count());
+}
+
+TraceRing& localTraceRing() {
+    thread_local TraceRing* ring = [] {
+        std::lock_guard<std::mutex> lock(traceRingsMutex);
+        traceRings.push_back(std::make_unique<TraceRing>());
+        traceRings.back()->tid = static_cast<uint32_t>(traceRings.size());
+        return traceRings.back().get();
+    }();
+    return *ring;
+}
+
+void recordTraceEvent(const char* name, uint64_t startNs, uint64_t endNs) {
+    TraceRing& ring = localTraceRing();
+    uint64_t h = ring.head.load(std::memory_order_relaxed);
+    ring.events[h & (TRACE_RING_EVENTS - 1)] = { name, startNs, endNs - startNs };
+    ring.head.store(h + 1, std::memory_order_release);
+}
+
+thread_local RequestProfile requestProfile;
+
+void noteRoutesScanned(size_t rows) {
+    if (requestProfile.active) requestProfile.routesScanned += rows;
+}
+
+// Chrome trace JSON (chrome://tracing, Perfetto) of the spans still in the
+// rings. Slots a writer may have reused during the copy are dropped.
+std::string renderChromeTrace(bool clear) {
+    std::vector<std::pair<uint32_t, TraceEvent>> events;
+    {
+        std::lock_guard<std::mutex> lock(traceRingsMutex);
+        for (const auto& ring : traceRings) {
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t first = std::max(ring->floor.load(std::memory_order_relaxed),
+                                      head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0);
+            size_t before = events.size();
+            for (uint64_t i = first; i < head; ++i) {
+                events.push_back({ ring->tid, ring->events[i & (TRACE_RING_EVENTS - 1)] });
+            }
+            uint64_t after = ring->head.load(std::memory_order_acquire);
+            if (after > TRACE_RING_EVENTS && after - TRACE_RING_EVENTS > first) {
+                size_t overwritten = static_cast<size_t>(
+                    std::min<uint64_t>(after - TRACE_RING_EVENTS - first, head - first));
+                events.erase(events.begin() + before, events.begin() + before + overwritten);
+            }
+            if (clear) ring->floor.store(head, std::memory_order_relaxed);
+        }
+    }
+
+    JsonWriter w(events.size() * 96 + 64);
+    w.beginObject().key("traceEvents").beginArray();
+    for (const auto& e : events) {
+        w.beginObject()
+            .field("name", e.second.name)
+            .field("cat", "app")
+            .field("ph", "X");
+        // timestamps are microseconds; 3 decimals keep nanosecond resolution
+        w.key("ts").fixed(e.second.startNs / 1e3, 3);
+        w.key("dur").fixed(e.second.durNs / 1e3, 3);
+        w.field("pid", 1)
+            .field("tid", static_cast<int>(e.first))
+            .endObject();
+    }
+    w.endArray().field("displayTimeUnit", "ms").endObject();
+    return w.take();
+}
+
+size_t traceThreadCount() {
+    std::lock_guard<std::mutex> lock(traceRingsMutex);
+    return traceRings.size();
+}
+
+// ---------- CSV Helpers ----------
+
+std::vector<std::string> parseCsvLine(const std::string& line) {
+    std::vector<std::string> result;
+    std::string field;
+    bool inQuotes = false;
+
+    for (char c : line) {
+        if (c == '"') {
+            inQuotes = !inQuotes;
+        } else if (c == ',' && !inQuotes) {
+            result.push_back(field);
+            field.clear();
+        } else {
+            field.push_back(c);
+        }
+    }
+    result.push_back(field);
+    return result;
+}
+
+bool isNullField(const std::string& s) {
+    return s == "\\N" || s.empty();
+}
+
+// ---------- ICAO Index ----------
+
+// Packs an ICAO code into a fixed-width integer key, one upper-cased byte per
+// character; 0 if the code is not exactly `width` letters or digits.
+uint32_t packIcao(std::string_view code, size_t width) {
+    if (code.size() != width) return 0;
+    uint32_t key = 0;
+    for (char c : code) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (!std::isalnum(u)) return 0;
+        key = (key << 8) | static_cast<unsigned char>(std::toupper(u));
+    }
+    return key;
+}
+
+Airline* getAirlineByIcao(const std::string& code) {
+    auto it = airlinesByIcao.find(packIcao(code, AIRLINE_ICAO_LEN));
+    if (it == airlinesByIcao.end()) return nullptr;
+    return it->second;
+}
+
+Airport* getAirportByIcao(const std::string& code) {
+    auto it = airportsByIcao.find(packIcao(code, AIRPORT_ICAO_LEN));
+    if (it == airportsByIcao.end()) return nullptr;
+    return it->second;
+}
+
+// ICAO codes are reused by defunct airlines, so an active airline keeps the
+// slot over an inactive one.
+void indexAirlineIcao(Dataset& d, Airline& a) {
+    uint32_t key = packIcao(a.icao, AIRLINE_ICAO_LEN);
+    if (key == 0) return;
+    Airline*& slot = d.airlinesByIcao[key];
+    if (slot && slot != &a && d.strings.view(slot->active) == "Y" && d.strings.view(a.active) != "Y") return;
+    slot = &a;
+}
+
+void unindexAirlineIcao(Dataset& d, const Airline& a) {
+    uint32_t key = packIcao(a.icao, AIRLINE_ICAO_LEN);
+    auto it = d.airlinesByIcao.find(key);
+    if (it == d.airlinesByIcao.end() || it->second != &a) return;
+    d.airlinesByIcao.erase(it);
+    // hand the code to another airline that shares it, if any
+    for (auto& kv : d.airlinesById) {
+        if (&kv.second != &a && packIcao(kv.second.icao, AIRLINE_ICAO_LEN) == key) indexAirlineIcao(d, kv.second);
+    }
+}
+
+void indexAirportIcao(Dataset& d, Airport& ap) {
+    uint32_t key = packIcao(ap.icao, AIRPORT_ICAO_LEN);
+    if (key != 0) d.airportsByIcao[key] = &ap;
+}
+
+void unindexAirportIcao(Dataset& d, const Airport& ap) {
+    uint32_t key = packIcao(ap.icao, AIRPORT_ICAO_LEN);
+    auto it = d.airportsByIcao.find(key);
+    if (it == d.airportsByIcao.end() || it->second != &ap) return;
+    d.airportsByIcao.erase(it);
+    for (auto& kv : d.airportsById) {
+        if (&kv.second != &ap && packIcao(kv.second.icao, AIRPORT_ICAO_LEN) == key) indexAirportIcao(d, kv.second);
+    }
+}
+
+// Haversine distance in kilometers
+double haversineKm(double lat1, double lon1, double lat2, double lon2) {
+    const double R = 6371.0; // Earth radius in km
+    double dLat = (lat2 - lat1) * PI / 180.0;
+    double dLon = (lon2 - lon1) * PI / 180.0;
+    double a =
+        std::sin(dLat / 2) * std::sin(dLat / 2) +
+        std::cos(lat1 * PI / 180.0) * std::cos(lat2 * PI / 180.0) *
+        std::sin(dLon / 2) * std::sin(dLon / 2);
+    double c = 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
+    return R * c;
+}
+
+// ---------- Loaders ----------
+
+// Holds poolLock (when given) for the rest of the scope.
+struct PoolGuard {
+    std::unique_lock<std::mutex> lock;
+    explicit PoolGuard(std::mutex* m) : lock(m ? std::unique_lock<std::mutex>(*m) : std::unique_lock<std::mutex>()) {}
+};
+
+bool loadAirlines(Dataset& d, const std::string& filename, std::mutex* poolLock) {
+    std::ifstream in(filename);
+    if (!in) {
+        std::cerr << "Failed to open airlines file: " << filename << "\n";
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        auto fields = parseCsvLine(line);
+        if (fields.size() < 8) continue;
+
+        Airline a;
+        if (!isNullField(fields[0])) a.id = std::stoi(fields[0]);
+        a.iata     = isNullField(fields[3]) ? "" : fields[3];
+        a.icao     = fields[4];
+        {
+            PoolGuard guard(poolLock);
+            a.name     = d.strings.intern(fields[1]);
+            a.alias    = d.strings.intern(fields[2]);
+            a.callsign = d.strings.intern(fields[5]);
+            a.country  = d.strings.intern(fields[6]);
+            a.active   = d.strings.intern(fields[7]);
+        }
+
+        if (a.id == -1) continue;
+        d.airlinesById[a.id] = a;
+    }
+
+    // build IATA and ICAO indexes
+    PoolGuard guard(poolLock);   // ICAO precedence reads the active flag
+    for (auto& kv : d.airlinesById) {
+        Airline& a = kv.second;
+        if (!a.iata.empty()) {
+            d.airlinesByIata[a.iata] = &a;
+        }
+        indexAirlineIcao(d, a);
+    }
+
+    std::cerr << "Loaded " << d.airlinesById.size() << " airlines.\n";
+    return true;
+}
+
+bool loadAirports(Dataset& d, const std::string& filename, std::mutex* poolLock) {
+    std::ifstream in(filename);
+    if (!in) {
+        std::cerr << "Failed to open airports file: " << filename << "\n";
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        auto fields = parseCsvLine(line);
+        if (fields.size() < 8) continue;
+
+        Airport ap;
+        if (!isNullField(fields[0])) ap.id = std::stoi(fields[0]);
+        ap.iata     = isNullField(fields[4]) ? "" : fields[4];
+        ap.icao     = fields[5];
+        ap.latitude  = isNullField(fields[6]) ? 0.0 : std::stod(fields[6]);
+        ap.longitude = isNullField(fields[7]) ? 0.0 : std::stod(fields[7]);
+        if (fields.size() >= 14) {
+            if (!isNullField(fields[8])) ap.altitudeFt = static_cast<int16_t>(std::stoi(fields[8]));
+            if (!isNullField(fields[9])) {
+                ap.utcOffsetMin = static_cast<int16_t>(std::lround(std::stod(fields[9]) * 60.0));
+            }
+            if (!isNullField(fields[10]) && !fields[10].empty()) ap.dst = fields[10][0];
+        }
+        {
+            PoolGuard guard(poolLock);
+            ap.name     = d.strings.intern(fields[1]);
+            ap.city     = d.strings.intern(fields[2]);
+            ap.country  = d.strings.intern(fields[3]);
+            if (fields.size() >= 14) {
+                ap.tz     = isNullField(fields[11]) ? 0 : d.strings.intern(fields[11]);
+                ap.type   = isNullField(fields[12]) ? 0 : d.strings.intern(fields[12]);
+                ap.source = isNullField(fields[13]) ? 0 : d.strings.intern(fields[13]);
+            }
+        }
+
+        if (ap.id == -1) continue;
+        d.airportsById[ap.id] = ap;
+    }
+
+    // build IATA and ICAO indexes
+    for (auto& kv : d.airportsById) {
+        Airport& ap = kv.second;
+        if (!ap.iata.empty()) {
+            d.airportsByIata[ap.iata] = &ap;
+        }
+        indexAirportIcao(d, ap);
+    }
+
+    std::cerr << "Loaded " << d.airportsById.size() << " airports.\n";
+    return true;
+}
+
+bool loadRoutes(Dataset& d, const std::string& filename, std::mutex* poolLock, std::string* error) {
+    std::ifstream in(filename);
+    if (!in) {
+        std::cerr << "Failed to open routes file: " << filename << "\n";
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        auto fields = parseCsvLine(line);
+        if (fields.size() < 8) continue;
+
+        Route r;
+        // fields: 0 airline code, 1 airline ID,
+        //         2 src code,   3 src ID,
+        //         4 dst code,   5 dst ID,
+        //         6 codeshare,  7 stops,
+        //         8 equipment
+        if (!isNullField(fields[1])) r.airlineId    = std::stoi(fields[1]);
+        if (!isNullField(fields[3])) r.srcAirportId = std::stoi(fields[3]);
+        if (!isNullField(fields[5])) r.dstAirportId = std::stoi(fields[5]);
+        if (!isNullField(fields[7])) r.stops        = std::stoi(fields[7]);
+        r.codeshare = fields[6] == "Y";
+
+        if (r.airlineId == -1 || r.srcAirportId == -1 || r.dstAirportId == -1)
+            continue;
+        if (fields.size() > 8) {
+            PoolGuard guard(poolLock);
+            r.equipment = d.strings.intern(fields[8]);
+        }
+
+        if (!d.routes.push_back(r)) {
+            // a partial route table would pass for a good load; refuse it
+            std::string message = "routes.dat needs more than 65536 airline or airport IDs";
+            std::cerr << message << "\n";
+            if (error) *error = message;
+            return false;
+        }
+    }
+
+    std::cerr << "Loaded " << d.routes.size() << " routes.\n";
+    return true;
+}
+
+// ---------- Lookup Helpers ----------
+
+Airline* getAirlineByIata(const std::string& code) {
+    auto it = airlinesByIata.find(code);
+    if (it == airlinesByIata.end()) return nullptr;
+    return it->second;
+}
+
+Airport* getAirportByIata(const std::string& code) {
+    auto it = airportsByIata.find(code);
+    if (it == airportsByIata.end()) return nullptr;
+    return it->second;
+}
+
+// ---------- Record Helpers ----------
+
+AirlineRecord airlineRecord(const Airline& a) {
+    AirlineRecord r;
+    r.id       = a.id;
+    r.name     = strings.str(a.name);
+    r.alias    = strings.str(a.alias);
+    r.iata     = a.iata;
+    r.icao     = a.icao;
+    r.callsign = strings.str(a.callsign);
+    r.country  = strings.str(a.country);
+    r.active   = strings.str(a.active);
+    return r;
+}
+
+AirportRecord airportRecord(const Airport& ap) {
+    AirportRecord r;
+    r.id           = ap.id;
+    r.name         = strings.str(ap.name);
+    r.city         = strings.str(ap.city);
+    r.country      = strings.str(ap.country);
+    r.iata         = ap.iata;
+    r.icao         = ap.icao;
+    r.latitude     = ap.latitude;
+    r.longitude    = ap.longitude;
+    r.altitudeFt   = ap.altitudeFt;
+    r.utcOffsetMin = ap.utcOffsetMin;
+    r.dst          = ap.dst;
+    r.tz           = strings.str(ap.tz);
+    r.type         = strings.str(ap.type);
+    r.source       = strings.str(ap.source);
+    return r;
+}
+
+// Applies the optional airports.dat columns 9-14 of an insert or update.
+void applyAirportTimeFields(const AirportFields& f, Airport& ap) {
+    if (f.altitudeFt) ap.altitudeFt = *f.altitudeFt;
+    if (f.utcOffsetMin) ap.utcOffsetMin = *f.utcOffsetMin;
+    if (f.dst) ap.dst = *f.dst;
+    if (f.tz) ap.tz = strings.intern(*f.tz);
+    if (f.type) ap.type = strings.intern(*f.type);
+    if (f.source) ap.source = strings.intern(*f.source);
+}
+
+// ---------- Route Postings ----------
+
+// Inverted indexes from equipment code, airline slot and airport slot to the
+// sorted route rows that match. Appends keep the lists sorted; deleting routes
+// compacts the columns, so the lists are rebuilt then. Guarded by dataMutex.
+using PostingList = std::vector<uint32_t>;
+
+struct RoutePostings {
+    // raw equipment field -> interned codes, e.g. "CR2 737" -> {CR2, 737}
+    std::unordered_map<StrId, std::vector<StrId>> equipmentSets;
+    std::unordered_map<StrId, PostingList> byEquipment;
+    std::vector<PostingList> byAirline;   // airline slot -> rows
+    std::vector<PostingList> bySrc;       // airport slot -> rows
+    std::vector<PostingList> byDst;       // airport slot -> rows
+
+    // Write path only (load or unique lock): interns the code set on first use.
+    const std::vector<StrId>& codesFor(StringPool& pool, StrId raw) {
+        auto it = equipmentSets.find(raw);
+        if (it != equipmentSets.end()) return it->second;
+        std::vector<StrId> codes;
+        std::string_view text = pool.view(raw);
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find(' ', pos);
+            if (end == std::string_view::npos) end = text.size();
+            if (end > pos) {
+                StrId code = pool.intern(text.substr(pos, end - pos));
+                if (std::find(codes.begin(), codes.end(), code) == codes.end()) codes.push_back(code);
+            }
+            pos = end + 1;
+        }
+        return equipmentSets.emplace(raw, std::move(codes)).first->second;
+    }
+
+    // Read path: code set of an already indexed raw equipment field.
+    const std::vector<StrId>& codesOf(StrId raw) const {
+        static const std::vector<StrId> none;
+        auto it = equipmentSets.find(raw);
+        return it == equipmentSets.end() ? none : it->second;
+    }
+
+    void add(Dataset& d, uint32_t row) {
+        const RouteStore& rs = d.routes;
+        if (byAirline.size() < rs.airlineSlots.size()) byAirline.resize(rs.airlineSlots.size());
+        if (bySrc.size() < rs.airportSlots.size()) {
+            bySrc.resize(rs.airportSlots.size());
+            byDst.resize(rs.airportSlots.size());
+        }
+        byAirline[rs.airline[row]].push_back(row);
+        bySrc[rs.src[row]].push_back(row);
+        byDst[rs.dst[row]].push_back(row);
+        for (StrId code : codesFor(d.strings, rs.equipment[row])) {
+            byEquipment[code].push_back(row);
+        }
+    }
+};
+
+RoutePostings routePostings;
+
+// Builds into out; its equipment code sets are kept and reused.
+void rebuildRoutePostings(RoutePostings& out, Dataset& d) {
+    RoutePostings fresh;
+    fresh.equipmentSets = std::move(out.equipmentSets);
+    for (size_t i = 0; i < d.routes.size(); ++i) {
+        fresh.add(d, static_cast<uint32_t>(i));
+    }
+    out = std::move(fresh);
+}
+
+void rebuildRoutePostings() {
+    rebuildRoutePostings(routePostings, liveDataset);
+}
+
+// Intersects sorted posting lists, walking the shortest and galloping
+// (exponential then binary search) through the longer ones.
+PostingList intersectPostings(std::vector<const PostingList*> lists) {
+    if (lists.empty()) return {};
+    std::sort(lists.begin(), lists.end(),
+              [](const PostingList* a, const PostingList* b) { return a->size() < b->size(); });
+
+    PostingList result = *lists[0];
+    for (size_t k = 1; k < lists.size() && !result.empty(); ++k) {
+        const PostingList& other = *lists[k];
+        size_t w = 0, pos = 0;
+        for (uint32_t x : result) {
+            // gallop until other[hi] >= x, then binary search [lo, hi)
+            size_t lo = pos, hi = pos, step = 1;
+            while (hi < other.size() && other[hi] < x) {
+                lo = hi + 1;
+                hi += step;
+                step *= 2;
+            }
+            auto it = std::lower_bound(other.begin() + lo,
+                                       other.begin() + std::min(hi, other.size()), x);
+            pos = static_cast<size_t>(it - other.begin());
+            if (pos == other.size()) break;
+            if (other[pos] == x) result[w++] = x;
+        }
+        result.resize(w);
+    }
+    return result;
+}
+
+// ---------- Route Aggregates ----------
+
+// Materialized per-airline and per-airport route counts, maintained by the
+// route insert/delete paths so the route-count reports only sort a short
+// precomputed list. Guarded by dataMutex.
+struct RouteAggregates {
+    // airline ID -> airport ID -> routes touching it (src and dst both count)
+    std::unordered_map<int, std::unordered_map<int, int>> airportsByAirline;
+    // airport ID -> airline ID -> routes starting or ending there
+    std::unordered_map<int, std::unordered_map<int, int>> airlinesByAirport;
+    // airline ID -> destination airport ID -> routes
+    std::unordered_map<int, std::unordered_map<int, int>> destinationsByAirline;
+    // airline ID -> destination city (StrId) -> routes
+    std::unordered_map<int, std::unordered_map<int, int>> citiesByAirline;
+
+    // airports resolves the destination city
+    void add(const Route& rt, const std::unordered_map<int, Airport>& airports) { apply(rt, airports, 1); }
+    void remove(const Route& rt, const std::unordered_map<int, Airport>& airports) { apply(rt, airports, -1); }
+
+    // Moves an airport's destination counts from one city (StrId) to another;
+    // either side may be -1 (airport unknown before / removed after).
+    void moveCity(int airportId, int fromKey, int toKey) {
+        if (fromKey == toKey) return;
+        for (auto& kv : destinationsByAirline) {
+            auto it = kv.second.find(airportId);
+            if (it == kv.second.end()) continue;
+            auto& cities = citiesByAirline[kv.first];
+            if (fromKey >= 0) bump(cities, fromKey, -it->second);
+            if (toKey >= 0) bump(cities, toKey, it->second);
+        }
+    }
+
+private:
+    template <typename Map, typename Key>
+    static void bump(Map& m, const Key& key, int delta) {
+        int& c = m[key];
+        c += delta;
+        if (c <= 0) m.erase(key);
+    }
+
+    void apply(const Route& rt, const std::unordered_map<int, Airport>& airports, int delta) {
+        bump(airportsByAirline[rt.airlineId], rt.srcAirportId, delta);
+        bump(airportsByAirline[rt.airlineId], rt.dstAirportId, delta);
+        bump(airlinesByAirport[rt.srcAirportId], rt.airlineId, delta);
+        if (rt.dstAirportId != rt.srcAirportId) {
+            bump(airlinesByAirport[rt.dstAirportId], rt.airlineId, delta);
+        }
+        bump(destinationsByAirline[rt.airlineId], rt.dstAirportId, delta);
+        auto ap = airports.find(rt.dstAirportId);
+        if (ap != airports.end()) {
+            bump(citiesByAirline[rt.airlineId], static_cast<int>(ap->second.city), delta);
+        }
+    }
+};
+
+RouteAggregates routeAggregates;
+// Same counts restricted to routes the airline operates itself
+// (codeshare flag unset), backing the operatedOnly report mode.
+RouteAggregates operatedAggregates;
+
+const RouteAggregates& aggregatesFor(bool operatedOnly) {
+    return operatedOnly ? operatedAggregates : routeAggregates;
+}
+
+void rebuildRouteAggregates(RouteAggregates& all, RouteAggregates& operated, const Dataset& d) {
+    all = RouteAggregates();
+    operated = RouteAggregates();
+    for (Route rt : d.routes) {
+        all.add(rt, d.airportsById);
+        if (!rt.codeshare) operated.add(rt, d.airportsById);
+    }
+}
+
+void rebuildRouteAggregates() {
+    rebuildRouteAggregates(routeAggregates, operatedAggregates, liveDataset);
+}
+
+void moveAggregatedCity(int airportId, int fromKey, int toKey) {
+    routeAggregates.moveCity(airportId, fromKey, toKey);
+    operatedAggregates.moveCity(airportId, fromKey, toKey);
+}
+
+// Appends a route and keeps the aggregates and postings in step.
+bool insertRoute(const Route& rt) {
+    if (!routes.push_back(rt)) return false;
+    routeAggregates.add(rt, airportsById);
+    if (!rt.codeshare) operatedAggregates.add(rt, airportsById);
+    routePostings.add(liveDataset, static_cast<uint32_t>(routes.size() - 1));
+    return true;
+}
+
+// Erases matching routes and keeps the aggregates and postings in step;
+// returns the count.
+template <typename Pred>
+size_t eraseRoutes(Pred pred) {
+    for (Route rt : routes) {
+        if (!pred(rt)) continue;
+        routeAggregates.remove(rt, airportsById);
+        if (!rt.codeshare) operatedAggregates.remove(rt, airportsById);
+    }
+    noteRoutesScanned(2 * routes.size());
+    size_t removed = routes.eraseIf(pred);
+    if (removed > 0) {
+        routes.releaseUnusedSlots();
+        rebuildRoutePostings();
+    }
+    return removed;
+}
+
+// ---------- Timezone Index ----------
+
+// Airport IDs grouped by tz database name and by UTC offset, each list kept
+// sorted. Lets timezone queries skip the full airport scan. Guarded by dataMutex.
+struct TimezoneIndex {
+    std::unordered_map<StrId, std::vector<int>> byTz;
+    std::map<int, std::vector<int>> byOffset;   // minutes east of UTC
+
+    void insert(const Airport& ap) {
+        insertSorted(byTz[ap.tz], ap.id);
+        insertSorted(byOffset[ap.utcOffsetMin], ap.id);
+    }
+
+    void remove(const Airport& ap) {
+        eraseSorted(byTz, ap.tz, ap.id);
+        eraseSorted(byOffset, static_cast<int>(ap.utcOffsetMin), ap.id);
+    }
+
+private:
+    static void insertSorted(std::vector<int>& ids, int id) {
+        auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+        if (pos == ids.end() || *pos != id) ids.insert(pos, id);
+    }
+
+    template <typename Map, typename Key>
+    static void eraseSorted(Map& m, const Key& key, int id) {
+        auto it = m.find(key);
+        if (it == m.end()) return;
+        auto pos = std::lower_bound(it->second.begin(), it->second.end(), id);
+        if (pos != it->second.end() && *pos == id) it->second.erase(pos);
+        if (it->second.empty()) m.erase(it);
+    }
+};
+
+TimezoneIndex timezoneIndex;
+
+void rebuildTimezoneIndex(TimezoneIndex& out, const Dataset& d) {
+    out = TimezoneIndex();
+    for (const auto& kv : d.airportsById) {
+        out.insert(kv.second);
+    }
+}
+
+// ---------- Autocomplete Index ----------
+
+// Case-folded keys over names, cities and codes in one sorted array. Names and
+// cities are keyed at every word start (offsets into the same folded text), so
+// "fran" finds "San Francisco". A sparse table of the highest route degree over
+// key order answers top-k for a prefix range without scanning the range.
+struct SuggestIndex {
+    enum Field : uint8_t { IATA, ICAO, NAME, CITY, CALLSIGN };
+
+    struct Entity {
+        int id;
+        int degree;
+    };
+    struct Key {
+        uint32_t off;
+        uint16_t len;
+        uint8_t field;
+        uint32_t entity;
+    };
+    struct Hit {
+        int id;
+        int degree;
+        uint8_t field;
+        bool fuzzy;
+    };
+
+    std::string text;                       // folded key bytes
+    std::vector<Entity> entities;
+    std::vector<Key> keys;                  // sorted by folded text
+    std::vector<std::vector<uint32_t>> best;  // best[j][i]: top key in [i, i + 2^j)
+    bool alphabet[128] = {};                // ASCII bytes seen, for fuzzy variants
+
+    static std::string fold(std::string_view s) {
+        std::string out;
+        out.reserve(s.size());
+        for (char c : s) {
+            unsigned char u = static_cast<unsigned char>(c);
+            out.push_back(u < 128 ? static_cast<char>(std::tolower(u)) : c);
+        }
+        return out;
+    }
+
+    void addEntity(int id, int degree) { entities.push_back({ id, degree }); }
+
+    // Keys the latest entity by a field value; wordStarts also keys each word.
+    void addField(std::string_view value, Field field, bool wordStarts) {
+        if (value.empty() || value == "\\N" || value == "-") return;
+        uint32_t base = static_cast<uint32_t>(text.size());
+        std::string folded = fold(value);
+        text += folded;
+        uint32_t entity = static_cast<uint32_t>(entities.size() - 1);
+        for (size_t i = 0; i < folded.size(); ++i) {
+            unsigned char u = static_cast<unsigned char>(folded[i]);
+            if (u < 128) alphabet[u] = true;
+            bool start = i == 0 || (wordStarts && !std::isalnum(static_cast<unsigned char>(folded[i - 1])) &&
+                                    std::isalnum(static_cast<unsigned char>(folded[i])));
+            if (!start) continue;
+            size_t len = std::min<size_t>(folded.size() - i, std::numeric_limits<uint16_t>::max());
+            keys.push_back({ base + static_cast<uint32_t>(i), static_cast<uint16_t>(len),
+                             static_cast<uint8_t>(field), entity });
+        }
+    }
+
+    std::string_view keyText(const Key& k) const { return std::string_view(text.data() + k.off, k.len); }
+    int keyDegree(uint32_t k) const { return entities[keys[k].entity].degree; }
+
+    uint32_t better(uint32_t a, uint32_t b) const {
+        int da = keyDegree(a), db = keyDegree(b);
+        if (da != db) return da > db ? a : b;
+        return std::min(a, b);
+    }
+
+    void finish() {
+        std::sort(keys.begin(), keys.end(), [this](const Key& a, const Key& b) {
+            return keyText(a) < keyText(b);
+        });
+        best.clear();
+        best.emplace_back(keys.size());
+        for (uint32_t i = 0; i < keys.size(); ++i) best[0][i] = i;
+        for (size_t span = 2; span <= keys.size(); span *= 2) {
+            const std::vector<uint32_t>& prev = best.back();
+            std::vector<uint32_t> level(keys.size() - span + 1);
+            for (size_t i = 0; i < level.size(); ++i) {
+                level[i] = better(prev[i], prev[i + span / 2]);
+            }
+            best.push_back(std::move(level));
+        }
+    }
+
+    // Highest-degree key in [lo, hi); the range must be non-empty.
+    uint32_t bestIn(size_t lo, size_t hi) const {
+        size_t j = 0;
+        while ((size_t(2) << j) <= hi - lo) ++j;
+        return better(best[j][lo], best[j][hi - (size_t(1) << j)]);
+    }
+
+    // Keys starting with `prefix`, searched within [from, to) when the caller
+    // already knows the range of a shorter prefix.
+    std::pair<size_t, size_t> prefixRange(std::string_view prefix, size_t from = 0,
+                                          size_t to = std::numeric_limits<size_t>::max()) const {
+        auto first = keys.begin() + from;
+        auto last = keys.begin() + std::min(to, keys.size());
+        auto lo = std::lower_bound(first, last, prefix,
+                                   [this](const Key& k, std::string_view p) { return keyText(k) < p; });
+        auto hi = std::upper_bound(lo, last, prefix,
+                                   [this](std::string_view p, const Key& k) {
+                                       return p < keyText(k).substr(0, p.size());
+                                   });
+        return { static_cast<size_t>(lo - keys.begin()), static_cast<size_t>(hi - keys.begin()) };
+    }
+
+    // Prefix ranges for every edit-distance-1 variant of the query (except
+    // trailing deletion, which only widens an ordinary prefix match). Edits at
+    // position i only search inside the range of the untouched prefix q[0, i).
+    std::vector<std::pair<size_t, size_t>> fuzzyRanges(const std::string& q) const {
+        std::vector<std::pair<size_t, size_t>> ranges;
+        std::pair<size_t, size_t> base = { 0, keys.size() };
+        auto probe = [&](const std::string& v) {
+            auto r = prefixRange(v, base.first, base.second);
+            if (r.first < r.second) ranges.push_back(r);
+        };
+        std::string v;
+        for (size_t i = 0; i < q.size(); ++i) {
+            if (i > 0) base = prefixRange(std::string_view(q).substr(0, i), base.first, base.second);
+            if (base.first == base.second) break;
+            if (i + 1 < q.size()) {
+                v = q;
+                v.erase(i, 1);
+                probe(v);
+                v = q;
+                std::swap(v[i], v[i + 1]);
+                probe(v);
+            }
+            for (int c = 1; c < 128; ++c) {
+                if (!alphabet[c]) continue;
+                v = q;
+                if (v[i] != static_cast<char>(c)) {
+                    v[i] = static_cast<char>(c);
+                    probe(v);
+                }
+                v = q;
+                v.insert(v.begin() + i, static_cast<char>(c));
+                probe(v);
+            }
+        }
+        std::sort(ranges.begin(), ranges.end());
+        std::vector<std::pair<size_t, size_t>> merged;
+        for (const auto& r : ranges) {
+            if (!merged.empty() && r.first <= merged.back().second) {
+                merged.back().second = std::max(merged.back().second, r.second);
+            } else {
+                merged.push_back(r);
+            }
+        }
+        return merged;
+    }
+
+    // Appends up to k entities not yet in `seen`, highest degree first.
+    void topK(const std::vector<std::pair<size_t, size_t>>& ranges, size_t k, bool fuzzy,
+              std::vector<Hit>& out, std::vector<uint8_t>& seen) const {
+        struct Item {
+            uint32_t key;
+            size_t lo, hi;
+        };
+        auto cmp = [this](const Item& a, const Item& b) { return better(a.key, b.key) != a.key; };
+        std::vector<Item> heap;
+        for (const auto& r : ranges) {
+            if (r.first < r.second) heap.push_back({ bestIn(r.first, r.second), r.first, r.second });
+        }
+        std::make_heap(heap.begin(), heap.end(), cmp);
+        while (!heap.empty() && out.size() < k) {
+            std::pop_heap(heap.begin(), heap.end(), cmp);
+            Item top = heap.back();
+            heap.pop_back();
+            const Key& key = keys[top.key];
+            if (!seen[key.entity]) {
+                seen[key.entity] = 1;
+                const Entity& e = entities[key.entity];
+                out.push_back({ e.id, e.degree, key.field, fuzzy });
+            }
+            if (top.lo < top.key) {
+                heap.push_back({ bestIn(top.lo, top.key), top.lo, top.key });
+                std::push_heap(heap.begin(), heap.end(), cmp);
+            }
+            if (top.key + 1 < top.hi) {
+                heap.push_back({ bestIn(top.key + 1, top.hi), top.key + 1, top.hi });
+                std::push_heap(heap.begin(), heap.end(), cmp);
+            }
+        }
+    }
+
+    std::vector<Hit> query(const std::string& folded, size_t k, bool fuzzy) const {
+        std::vector<Hit> out;
+        if (keys.empty() || folded.empty()) return out;
+        static thread_local std::vector<uint8_t> seen;
+        seen.assign(entities.size(), 0);
+        topK({ prefixRange(folded) }, k, false, out, seen);
+        if (fuzzy && out.size() < k && folded.size() >= 3) {
+            topK(fuzzyRanges(folded), k, true, out, seen);
+        }
+        return out;
+    }
+};
+
+struct SuggestSnapshot {
+    uint64_t version = 0;
+    SuggestIndex airports;
+    SuggestIndex airlines;
+};
+
+// Caller must hold dataMutex (shared is enough).
+std::shared_ptr<const SuggestSnapshot> buildSuggestSnapshot() {
+    auto s = std::make_shared<SuggestSnapshot>();
+    s->version = datasetVersion.load();
+
+    // route degree per airport slot (either end) and per airline slot
+    std::vector<int> airportDegree(airportSlots.size(), 0);
+    std::vector<int> airlineDegree(airlineSlots.size(), 0);
+    noteRoutesScanned(routes.size());
+    for (size_t i = 0; i < routes.size(); ++i) {
+        airportDegree[routes.src[i]] += 1;
+        airportDegree[routes.dst[i]] += 1;
+        airlineDegree[routes.airline[i]] += 1;
+    }
+    auto degreeOf = [](const DenseIndex& slots, const std::vector<int>& degree, int id) {
+        int slot = slots.find(id);
+        return slot >= 0 && slot < static_cast<int>(degree.size()) ? degree[slot] : 0;
+    };
+
+    for (const auto& kv : airportsById) {
+        const Airport& ap = kv.second;
+        s->airports.addEntity(ap.id, degreeOf(airportSlots, airportDegree, ap.id));
+        s->airports.addField(ap.iata, SuggestIndex::IATA, false);
+        s->airports.addField(ap.icao, SuggestIndex::ICAO, false);
+        s->airports.addField(strings.view(ap.name), SuggestIndex::NAME, true);
+        s->airports.addField(strings.view(ap.city), SuggestIndex::CITY, true);
+    }
+    for (const auto& kv : airlinesById) {
+        const Airline& al = kv.second;
+        s->airlines.addEntity(al.id, degreeOf(airlineSlots, airlineDegree, al.id));
+        s->airlines.addField(al.iata, SuggestIndex::IATA, false);
+        s->airlines.addField(al.icao, SuggestIndex::ICAO, false);
+        s->airlines.addField(strings.view(al.name), SuggestIndex::NAME, true);
+        s->airlines.addField(strings.view(al.callsign), SuggestIndex::CALLSIGN, true);
+    }
+    s->airports.finish();
+    s->airlines.finish();
+    return s;
+}
+
+std::shared_ptr<const SuggestSnapshot> cachedSuggest; // std::atomic_load/store
+std::mutex suggestBuildMutex;
+
+// Index for the current dataset version, rebuilt on first use after a change.
+// Caller must hold dataMutex (shared is enough). One reader builds; the
+// others that miss wait for it instead of building their own copy.
+std::shared_ptr<const SuggestSnapshot> currentSuggestIndex() {
+    auto s = std::atomic_load(&cachedSuggest);
+    if (s && s->version == datasetVersion.load()) return s;
+    std::lock_guard<std::mutex> build(suggestBuildMutex);
+    s = std::atomic_load(&cachedSuggest);
+    if (s && s->version == datasetVersion.load()) return s;
+    s = buildSuggestSnapshot();
+    std::atomic_store(&cachedSuggest, s);
+    return s;
+}
+
+// ---------- Spatial Index ----------
+
+// Airports bucketed into a fixed lat/lon grid. Queries visit cells in order of
+// a great-circle lower bound, so k-nearest and radius searches only touch the
+// cells that could still contain a closer airport. Guarded by dataMutex.
+const double GEO_CELL_DEG = 5.0;
+const int GEO_ROWS = 36;   // 180 / GEO_CELL_DEG
+const int GEO_COLS = 72;   // 360 / GEO_CELL_DEG
+const double EARTH_RADIUS_KM = 6371.0;
+
+struct SpatialIndex {
+    std::vector<std::vector<int>> cells = std::vector<std::vector<int>>(GEO_ROWS * GEO_COLS);
+    std::unordered_map<int, int> cellOf;   // airport ID -> cell
+
+    static int cellFor(double lat, double lon) {
+        int row = static_cast<int>(std::floor((lat + 90.0) / GEO_CELL_DEG));
+        int col = static_cast<int>(std::floor((lon + 180.0) / GEO_CELL_DEG));
+        row = std::max(0, std::min(GEO_ROWS - 1, row));
+        col = ((col % GEO_COLS) + GEO_COLS) % GEO_COLS;
+        return row * GEO_COLS + col;
+    }
+
+    void insert(const Airport& ap) {
+        remove(ap.id);
+        int cell = cellFor(ap.latitude, ap.longitude);
+        cells[cell].push_back(ap.id);
+        cellOf[ap.id] = cell;
+    }
+
+    void remove(int airportId) {
+        auto it = cellOf.find(airportId);
+        if (it == cellOf.end()) return;
+        auto& bucket = cells[it->second];
+        bucket.erase(std::remove(bucket.begin(), bucket.end(), airportId), bucket.end());
+        cellOf.erase(it);
+    }
+};
+
+SpatialIndex spatialIndex;
+
+void rebuildSpatialIndex(SpatialIndex& out, const Dataset& d) {
+    out = SpatialIndex();
+    for (const auto& kv : d.airportsById) {
+        out.insert(kv.second);
+    }
+}
+
+// Lower bound on the great-circle distance from (lat, lon) to any point in a
+// cell: the larger of the latitude gap and the distance to the great circles
+// of the two bounding meridians.
+double cellLowerBoundKm(double lat, double lon, int cell) {
+    double lat0 = -90.0 + (cell / GEO_COLS) * GEO_CELL_DEG;
+    double lon0 = -180.0 + (cell % GEO_COLS) * GEO_CELL_DEG;
+    double lat1 = lat0 + GEO_CELL_DEG;
+    double lon1 = lon0 + GEO_CELL_DEG;
+
+    double latGap = std::max({ 0.0, lat0 - lat, lat - lat1 });
+    double bound = latGap * PI / 180.0 * EARTH_RADIUS_KM;
+
+    double offset = std::fmod(lon - lon0 + 720.0, 360.0);
+    if (offset > GEO_CELL_DEG) {
+        double c = std::cos(lat * PI / 180.0);
+        double d0 = std::asin(std::min(1.0, std::fabs(c * std::sin((lon - lon0) * PI / 180.0))));
+        double d1 = std::asin(std::min(1.0, std::fabs(c * std::sin((lon - lon1) * PI / 180.0))));
+        bound = std::max(bound, std::min(d0, d1) * EARTH_RADIUS_KM);
+    }
+    return bound;
+}
+
+struct GeoHit {
+    const Airport* airport;
+    double km;
+};
+
+// Non-empty cells ordered by lower bound, skipping any beyond maxKm.
+std::vector<std::pair<double, int>> candidateCells(double lat, double lon, double maxKm) {
+    std::vector<std::pair<double, int>> order;
+    for (int cell = 0; cell < GEO_ROWS * GEO_COLS; ++cell) {
+        if (spatialIndex.cells[cell].empty()) continue;
+        double bound = cellLowerBoundKm(lat, lon, cell);
+        if (bound <= maxKm) order.push_back({ bound, cell });
+    }
+    std::sort(order.begin(), order.end());
+    return order;
+}
+
+std::vector<GeoHit> nearestAirports(double lat, double lon, size_t k) {
+    auto farther = [](const GeoHit& a, const GeoHit& b) { return a.km < b.km; };
+    std::vector<GeoHit> heap; // max-heap on distance, holds the best k so far
+    if (k == 0) return heap;
+
+    for (const auto& entry : candidateCells(lat, lon, 1e9)) {
+        if (heap.size() == k && entry.first > heap.front().km) break;
+        for (int id : spatialIndex.cells[entry.second]) {
+            const Airport& ap = airportsById.at(id);
+            double km = haversineKm(lat, lon, ap.latitude, ap.longitude);
+            if (heap.size() < k) {
+                heap.push_back({ &ap, km });
+                std::push_heap(heap.begin(), heap.end(), farther);
+            } else if (km < heap.front().km) {
+                std::pop_heap(heap.begin(), heap.end(), farther);
+                heap.back() = { &ap, km };
+                std::push_heap(heap.begin(), heap.end(), farther);
+            }
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), farther);
+    return heap;
+}
+
+std::vector<GeoHit> airportsWithin(double lat, double lon, double radiusKm) {
+    std::vector<GeoHit> hits;
+    for (const auto& entry : candidateCells(lat, lon, radiusKm)) {
+        for (int id : spatialIndex.cells[entry.second]) {
+            const Airport& ap = airportsById.at(id);
+            double km = haversineKm(lat, lon, ap.latitude, ap.longitude);
+            if (km <= radiusKm) hits.push_back({ &ap, km });
+        }
+    }
+    std::sort(hits.begin(), hits.end(),
+              [](const GeoHit& a, const GeoHit& b) { return a.km < b.km; });
+    return hits;
+}
+
+std::vector<GeoAirport> geoAirports(const std::vector<GeoHit>& hits) {
+    std::vector<GeoAirport> out(hits.size());
+    for (size_t i = 0; i < hits.size(); ++i) {
+        const Airport* ap = hits[i].airport;
+        out[i].id         = ap->id;
+        out[i].iata       = ap->iata;
+        out[i].name       = strings.str(ap->name);
+        out[i].city       = strings.str(ap->city);
+        out[i].country    = strings.str(ap->country);
+        out[i].latitude   = ap->latitude;
+        out[i].longitude  = ap->longitude;
+        out[i].distanceKm = hits[i].km;
+    }
+    return out;
+}
+
+// ---------- Route Graph ----------
+
+// With EngineOptions::graphAirportsOnly, stations and ports stay available to
+// lookups but are left out of the route graph, the component index and
+// one-hop hubs.
+bool inRouteGraph(const Airport& ap, const StringPool& pool = strings) {
+    if (!graphAirportsOnly) return true;
+    std::string_view type = pool.view(ap.type);
+    return type != "station" && type != "port";
+}
+
+// Immutable snapshot of the route network with airports renumbered to dense
+// node indices (sorted by airport ID) and deduplicated adjacency in CSR form.
+struct RouteGraph {
+    uint64_t version = 0;
+    std::vector<int> airportIds;            // node -> airport ID
+    std::unordered_map<int, int> nodeOf;    // airport ID -> node
+    std::vector<int> outStart;              // size nodes + 1
+    std::vector<int> outAdj;
+    std::vector<double> outKm;              // great-circle length of each edge
+
+    int nodeCount() const { return static_cast<int>(airportIds.size()); }
+
+    int node(int airportId) const {
+        auto it = nodeOf.find(airportId);
+        return it == nodeOf.end() ? -1 : it->second;
+    }
+};
+
+// Caller must hold dataMutex (shared is enough) when d is the live dataset.
+std::shared_ptr<RouteGraph> buildRouteGraph(const Dataset& d = liveDataset) {
+    const RouteStore& routes = d.routes;
+    const DenseIndex& airportSlots = routes.airportSlots;
+    auto g = std::make_shared<RouteGraph>();
+    g->version = datasetVersion.load();
+
+    g->airportIds.reserve(d.airportsById.size());
+    for (const auto& kv : d.airportsById) {
+        if (inRouteGraph(kv.second, d.strings)) g->airportIds.push_back(kv.first);
+    }
+    std::sort(g->airportIds.begin(), g->airportIds.end());
+    g->nodeOf.reserve(g->airportIds.size());
+    for (size_t i = 0; i < g->airportIds.size(); ++i) {
+        g->nodeOf[g->airportIds[i]] = static_cast<int>(i);
+    }
+
+    std::vector<int> nodeOfSlot(airportSlots.size(), -1);
+    for (size_t slot = 0; slot < airportSlots.size(); ++slot) {
+        nodeOfSlot[slot] = g->node(airportSlots.idOf[slot]);
+    }
+
+    std::vector<std::pair<int, int>> edges;
+    edges.reserve(routes.size());
+    noteRoutesScanned(routes.size());
+    for (size_t i = 0; i < routes.size(); ++i) {
+        int s = nodeOfSlot[routes.src[i]];
+        int t = nodeOfSlot[routes.dst[i]];
+        if (s < 0 || t < 0 || s == t) continue;
+        edges.push_back({ s, t });
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    int n = g->nodeCount();
+    g->outStart.assign(n + 1, 0);
+    g->outAdj.reserve(edges.size());
+    g->outKm.reserve(edges.size());
+    for (const auto& e : edges) {
+        g->outStart[e.first + 1] += 1;
+        g->outAdj.push_back(e.second);
+        const Airport& a = d.airportsById.at(g->airportIds[e.first]);
+        const Airport& b = d.airportsById.at(g->airportIds[e.second]);
+        g->outKm.push_back(haversineKm(a.latitude, a.longitude, b.latitude, b.longitude));
+    }
+    for (int i = 0; i < n; ++i) {
+        g->outStart[i + 1] += g->outStart[i];
+    }
+    return g;
+}
+
+std::shared_ptr<const RouteGraph> cachedRouteGraph; // std::atomic_load/store
+
+// Graph for the current dataset version, built on first use after a change.
+// Caller must hold dataMutex (shared is enough).
+std::shared_ptr<const RouteGraph> currentRouteGraph() {
+    auto g = std::atomic_load(&cachedRouteGraph);
+    if (g && g->version == datasetVersion.load()) return g;
+    g = buildRouteGraph();
+    std::atomic_store(&cachedRouteGraph, g);
+    return g;
+}
+
+std::shared_ptr<const RouteGraph> routeGraphSnapshot() {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    return currentRouteGraph();
+}
+
+// ---------- Component Index ----------
+
+// Strongly and weakly connected components of the directed route graph.
+// SCC IDs come out of Tarjan in reverse topological order, so sccRank gives a
+// topological order of the condensation: an edge u -> v between different
+// SCCs always has sccRank[u] < sccRank[v]. Guarded by dataMutex; rebuilt at
+// load and updated incrementally by the mutation handlers where possible.
+struct ComponentIndex {
+    std::unordered_map<int, int> nodeOf;   // airport ID -> node
+    std::vector<int> sccOf;                // node -> SCC ID
+    std::vector<int> wccOf;                // node -> WCC ID
+    std::vector<int> sccRank;              // SCC ID -> topological rank
+    std::vector<int> sccSize;
+    std::vector<int> wccSize;
+
+    int node(int airportId) const {
+        auto it = nodeOf.find(airportId);
+        return it == nodeOf.end() ? -1 : it->second;
+    }
+};
+
+ComponentIndex components;
+
+void rebuildComponents(ComponentIndex& out, const std::shared_ptr<const RouteGraph>& g) {
+    int n = g->nodeCount();
+    ComponentIndex c;
+    c.nodeOf = g->nodeOf;
+    c.sccOf.assign(n, -1);
+
+    // iterative Tarjan
+    std::vector<int> index(n, -1), low(n, 0), stack, callStack, edgePos(n, 0);
+    std::vector<char> onStack(n, 0);
+    int counter = 0;
+    for (int root = 0; root < n; ++root) {
+        if (index[root] >= 0) continue;
+        callStack.push_back(root);
+        while (!callStack.empty()) {
+            int u = callStack.back();
+            if (index[u] < 0) {
+                index[u] = low[u] = counter++;
+                edgePos[u] = g->outStart[u];
+                stack.push_back(u);
+                onStack[u] = 1;
+            }
+            if (edgePos[u] < g->outStart[u + 1]) {
+                int v = g->outAdj[edgePos[u]++];
+                if (index[v] < 0) {
+                    callStack.push_back(v);
+                } else if (onStack[v]) {
+                    low[u] = std::min(low[u], index[v]);
+                }
+                continue;
+            }
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                int parent = callStack.back();
+                low[parent] = std::min(low[parent], low[u]);
+            }
+            if (low[u] == index[u]) {
+                int id = static_cast<int>(c.sccSize.size());
+                int size = 0;
+                int w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    onStack[w] = 0;
+                    c.sccOf[w] = id;
+                    ++size;
+                } while (w != u);
+                c.sccSize.push_back(size);
+            }
+        }
+    }
+    int sccCount = static_cast<int>(c.sccSize.size());
+    c.sccRank.resize(sccCount);
+    for (int id = 0; id < sccCount; ++id) c.sccRank[id] = sccCount - 1 - id;
+
+    // weak components via union-find
+    std::vector<int> parent(n);
+    for (int i = 0; i < n; ++i) parent[i] = i;
+    auto find = [&parent](int x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    };
+    for (int u = 0; u < n; ++u) {
+        for (int i = g->outStart[u]; i < g->outStart[u + 1]; ++i) {
+            int a = find(u), b = find(g->outAdj[i]);
+            if (a != b) parent[a] = b;
+        }
+    }
+    std::unordered_map<int, int> wccIdOfRoot;
+    c.wccOf.resize(n);
+    for (int u = 0; u < n; ++u) {
+        auto ins = wccIdOfRoot.emplace(find(u), static_cast<int>(c.wccSize.size()));
+        if (ins.second) c.wccSize.push_back(0);
+        c.wccOf[u] = ins.first->second;
+        c.wccSize[c.wccOf[u]] += 1;
+    }
+
+    out = std::move(c);
+}
+
+void rebuildComponents() {
+    rebuildComponents(components, buildRouteGraph());
+}
+
+void recomputeComponents() {
+    std::unique_lock<std::shared_mutex> lock(dataMutex);
+    rebuildComponents();
+}
+
+void componentsOnAirportAdded(int airportId) {
+    if (components.node(airportId) >= 0) return;
+    auto ap = airportsById.find(airportId);
+    if (ap == airportsById.end() || !inRouteGraph(ap->second)) return;
+    int node = static_cast<int>(components.sccOf.size());
+    components.nodeOf[airportId] = node;
+    components.sccOf.push_back(static_cast<int>(components.sccSize.size()));
+    components.sccRank.push_back(static_cast<int>(components.sccSize.size()));
+    components.sccSize.push_back(1);
+    components.wccOf.push_back(static_cast<int>(components.wccSize.size()));
+    components.wccSize.push_back(1);
+}
+
+void componentsOnRouteAdded(const Route& rt) {
+    int u = components.node(rt.srcAirportId);
+    int v = components.node(rt.dstAirportId);
+    if (u < 0 || v < 0) {
+        auto a = airportsById.find(rt.srcAirportId);
+        auto b = airportsById.find(rt.dstAirportId);
+        if (a != airportsById.end() && !inRouteGraph(a->second)) return;
+        if (b != airportsById.end() && !inRouteGraph(b->second)) return;
+        rebuildComponents();
+        return;
+    }
+    int su = components.sccOf[u], sv = components.sccOf[v];
+    if (su == sv) return;
+    if (components.sccRank[su] > components.sccRank[sv]) {
+        // backward edge in the condensation may close a cycle
+        rebuildComponents();
+        return;
+    }
+    // forward edge: SCCs and topological order stay valid, weak components may merge
+    int wu = components.wccOf[u], wv = components.wccOf[v];
+    if (wu == wv) return;
+    for (auto& w : components.wccOf) {
+        if (w == wv) w = wu;
+    }
+    components.wccSize[wu] += components.wccSize[wv];
+    components.wccSize[wv] = 0;
+}
+
+// Call after the route has been erased from `routes`.
+void componentsOnRouteRemoved(int srcAirportId, int dstAirportId) {
+    int s = airportSlots.find(srcAirportId);
+    int d = airportSlots.find(dstAirportId);
+    bool stillServed = false;
+    if (s >= 0 && d >= 0) {
+        forEachEq(routes.src.data(), nullptr, routes.size(), static_cast<DenseIdx>(s),
+                  [&](size_t i) { if (routes.dst[i] == d) stillServed = true; });
+        noteRoutesScanned(routes.size());
+    }
+    if (stillServed) return; // edge still served by another airline
+    rebuildComponents();
+}
+
+// 1 = reachable, 0 = provably unreachable, -1 = unknown (needs a search).
+int componentReachability(int srcAirportId, int dstAirportId) {
+    int u = components.node(srcAirportId);
+    int v = components.node(dstAirportId);
+    if (u < 0 || v < 0) return -1;
+    if (components.wccOf[u] != components.wccOf[v]) return 0;
+    int su = components.sccOf[u], sv = components.sccOf[v];
+    if (su == sv) return 1;
+    if (components.sccRank[su] > components.sccRank[sv]) return 0;
+    return -1;
+}
+
+// ---------- Parallel Helpers ----------
+
+// Workers for the background rebuilds. Defaults to half the cores so a
+// rebuild after every mutation burst leaves the rest to request threads.
+unsigned analyticsThreadCount() {
+    unsigned n = analyticsThreads;
+    if (n == 0) n = std::thread::hardware_concurrency() / 2;
+    return n > 0 ? n : 1;
+}
+
+// Runs fn(workerIndex) on analyticsThreadCount() threads and waits for all.
+template <typename Fn>
+void runParallel(Fn fn) {
+    unsigned n = analyticsThreadCount();
+    std::vector<std::thread> threads;
+    threads.reserve(n - 1);
+    for (unsigned t = 1; t < n; ++t) {
+        threads.emplace_back(fn, t);
+    }
+    fn(0u);
+    for (auto& th : threads) th.join();
+}
+
+// ---------- Hop Matrix ----------
+
+// Minimum hop counts between all airport pairs, two 4-bit entries per byte.
+// 0 = same airport, 1..14 = hops (14 means "14 or more"), 15 = unreachable.
+const uint8_t HOPS_SATURATED   = 14;
+const uint8_t HOPS_UNREACHABLE = 15;
+
+struct HopMatrix {
+    std::shared_ptr<const RouteGraph> graph;
+    size_t rowBytes = 0;
+    std::vector<uint8_t> cells;
+
+    uint8_t get(int src, int dst) const {
+        uint8_t b = cells[src * rowBytes + dst / 2];
+        return (dst & 1) ? static_cast<uint8_t>(b >> 4) : static_cast<uint8_t>(b & 0x0F);
+    }
+};
+
+std::shared_ptr<const HopMatrix> hopMatrix; // swapped with std::atomic_load/store
+
+std::shared_ptr<const HopMatrix> computeHopMatrix(std::shared_ptr<const RouteGraph> g) {
+    auto m = std::make_shared<HopMatrix>();
+    int n = g->nodeCount();
+    m->graph = g;
+    m->rowBytes = (static_cast<size_t>(n) + 1) / 2; // rows never share a byte
+    m->cells.assign(static_cast<size_t>(n) * m->rowBytes, 0xFF);
+
+    std::atomic<int> nextSource{0};
+    runParallel([&](unsigned) {
+        std::vector<int> seen(n, -1);
+        std::vector<int> frontier, next;
+        frontier.reserve(n);
+        next.reserve(n);
+
+        for (int s; (s = nextSource.fetch_add(1)) < n; ) {
+            uint8_t* row = &m->cells[s * m->rowBytes];
+            auto put = [row](int d, uint8_t h) {
+                uint8_t& b = row[d / 2];
+                b = (d & 1) ? static_cast<uint8_t>((b & 0x0F) | (h << 4))
+                            : static_cast<uint8_t>((b & 0xF0) | h);
+            };
+
+            frontier.clear();
+            frontier.push_back(s);
+            seen[s] = s;
+            put(s, 0);
+            for (int depth = 1; !frontier.empty(); ++depth) {
+                uint8_t h = static_cast<uint8_t>(std::min(depth, static_cast<int>(HOPS_SATURATED)));
+                next.clear();
+                for (int u : frontier) {
+                    for (int i = g->outStart[u]; i < g->outStart[u + 1]; ++i) {
+                        int v = g->outAdj[i];
+                        if (seen[v] == s) continue;
+                        seen[v] = s;
+                        put(v, h);
+                        next.push_back(v);
+                    }
+                }
+                frontier.swap(next);
+            }
+        }
+    });
+    return m;
+}
+
+// Fills one src/dst row from the matrix; maxStops < 0 means no limit.
+void fillHopRow(HopRow& out, const HopMatrix& m, const Airport* src, const Airport* dst, int maxStops) {
+    out.src = src->iata;
+    out.dst = dst->iata;
+
+    int s = m.graph->node(src->id);
+    int d = m.graph->node(dst->id);
+    if (s < 0 || d < 0) {
+        out.error = "Airport not in hop matrix yet";
+        return;
+    }
+
+    uint8_t h = m.get(s, d);
+    bool reachable = h != HOPS_UNREACHABLE;
+    if (reachable) {
+        out.hops = h;
+        out.saturated = h == HOPS_SATURATED;
+    }
+    if (maxStops >= 0) {
+        // src == dst needs no flight at all; a saturated cell only bounds
+        // the stops from below, so a large enough maxStops is undecided
+        out.maxStops = maxStops;
+        if (reachable && h == HOPS_SATURATED && maxStops >= HOPS_SATURATED - 1) {
+            out.withinMaxStops = -1;
+        } else {
+            out.withinMaxStops = reachable && (h == 0 || h - 1 <= maxStops);
+        }
+    }
+}
+
+// ---------- Centrality ----------
+
+// Betweenness (Brandes, unweighted, directed) and PageRank over one graph
+// snapshot. Both vectors are indexed by graph node.
+struct CentralityReport {
+    std::shared_ptr<const RouteGraph> graph;
+    std::vector<double> betweenness;
+    std::vector<double> pagerank;
+    long long computeMs = 0;
+};
+
+std::shared_ptr<const CentralityReport> centralityReport; // std::atomic_load/store
+
+std::vector<double> computeBetweenness(const RouteGraph& g) {
+    int n = g.nodeCount();
+    unsigned workers = analyticsThreadCount();
+    std::vector<std::vector<double>> partial(workers);
+    std::atomic<int> nextSource{0};
+
+    runParallel([&](unsigned w) {
+        std::vector<double>& acc = partial[w];
+        acc.assign(n, 0.0);
+        std::vector<double> sigma(n, 0.0), delta(n, 0.0);
+        std::vector<int> dist(n, -1);
+        std::vector<int> order;
+        order.reserve(n);
+
+        for (int s; (s = nextSource.fetch_add(1)) < n; ) {
+            order.clear();
+            order.push_back(s);
+            dist[s] = 0;
+            sigma[s] = 1.0;
+            for (size_t head = 0; head < order.size(); ++head) {
+                int u = order[head];
+                for (int i = g.outStart[u]; i < g.outStart[u + 1]; ++i) {
+                    int v = g.outAdj[i];
+                    if (dist[v] < 0) {
+                        dist[v] = dist[u] + 1;
+                        order.push_back(v);
+                    }
+                    if (dist[v] == dist[u] + 1) sigma[v] += sigma[u];
+                }
+            }
+
+            // dependency accumulation in reverse BFS order
+            for (size_t k = order.size(); k-- > 0; ) {
+                int u = order[k];
+                for (int i = g.outStart[u]; i < g.outStart[u + 1]; ++i) {
+                    int v = g.outAdj[i];
+                    if (dist[v] == dist[u] + 1) {
+                        delta[u] += sigma[u] / sigma[v] * (1.0 + delta[v]);
+                    }
+                }
+                if (u != s) acc[u] += delta[u];
+            }
+
+            for (int u : order) {
+                dist[u] = -1;
+                sigma[u] = 0.0;
+                delta[u] = 0.0;
+            }
+        }
+    });
+
+    std::vector<double> bc(n, 0.0);
+    for (const auto& acc : partial) {
+        if (acc.empty()) continue;
+        for (int i = 0; i < n; ++i) bc[i] += acc[i];
+    }
+    return bc;
+}
+
+std::vector<double> computePageRank(const RouteGraph& g) {
+    const double damping = 0.85;
+    const int maxIterations = 100;
+    const double tolerance = 1e-10;
+
+    int n = g.nodeCount();
+    if (n == 0) return {};
+    std::vector<double> rank(n, 1.0 / n), next(n);
+    for (int iter = 0; iter < maxIterations; ++iter) {
+        double dangling = 0.0;
+        std::fill(next.begin(), next.end(), 0.0);
+        for (int u = 0; u < n; ++u) {
+            int deg = g.outStart[u + 1] - g.outStart[u];
+            if (deg == 0) {
+                dangling += rank[u];
+                continue;
+            }
+            double share = rank[u] / deg;
+            for (int i = g.outStart[u]; i < g.outStart[u + 1]; ++i) {
+                next[g.outAdj[i]] += share;
+            }
+        }
+
+        double base = (1.0 - damping) / n + damping * dangling / n;
+        double diff = 0.0;
+        for (int u = 0; u < n; ++u) {
+            double v = base + damping * next[u];
+            diff += std::fabs(v - rank[u]);
+            rank[u] = v;
+        }
+        if (diff < tolerance) break;
+    }
+    return rank;
+}
+
+std::shared_ptr<const CentralityReport> computeCentrality(std::shared_ptr<const RouteGraph> g) {
+    auto start = std::chrono::steady_clock::now();
+    auto report = std::make_shared<CentralityReport>();
+    report->graph = g;
+    report->betweenness = computeBetweenness(*g);
+    report->pagerank = computePageRank(*g);
+    report->computeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+// ---------- Isochrone ----------
+
+// Bounded Dijkstra over (airport, legs) states: every airport reachable from
+// the origins within maxKm of flown distance and at most maxStops stops.
+// Scratch buffers are kept per thread and only the touched entries are reset,
+// so repeated queries do not allocate.
+struct IsochroneHit {
+    int node;
+    double km;
+    int stops;
+};
+
+struct IsochroneScratch {
+    std::vector<double> best;        // node * (maxLegs + 1) + legs -> km
+    std::vector<int> touched;        // indices of best[] to reset
+    std::vector<double> nodeKm;      // node -> best km over any legs
+    std::vector<int> nodeStops;
+    std::vector<int> reached;
+    struct Entry { double km; int node; int legs; };
+    std::vector<Entry> heap;
+};
+
+void computeIsochrone(const RouteGraph& g, const std::vector<int>& origins,
+                      double maxKm, int maxStops, std::vector<IsochroneHit>& out) {
+    static thread_local IsochroneScratch sc;
+    const double INF = std::numeric_limits<double>::infinity();
+    int n = g.nodeCount();
+    int maxLegs = maxStops + 1;
+    int width = maxLegs + 1;
+
+    if (sc.best.size() < static_cast<size_t>(n) * width) sc.best.resize(static_cast<size_t>(n) * width, INF);
+    if (sc.nodeKm.size() < static_cast<size_t>(n)) {
+        sc.nodeKm.resize(n, INF);
+        sc.nodeStops.resize(n, 0);
+    }
+    sc.touched.clear();
+    sc.reached.clear();
+    sc.heap.clear();
+    out.clear();
+
+    auto cmp = [](const IsochroneScratch::Entry& a, const IsochroneScratch::Entry& b) {
+        return a.km > b.km;
+    };
+    auto relax = [&](int node, int legs, double km) {
+        size_t base = static_cast<size_t>(node) * width;
+        // dominated by a label with no more legs and no more distance
+        for (int l = 0; l <= legs; ++l) {
+            if (sc.best[base + l] <= km) return;
+        }
+        sc.best[base + legs] = km;
+        sc.touched.push_back(static_cast<int>(base + legs));
+        sc.heap.push_back({ km, node, legs });
+        std::push_heap(sc.heap.begin(), sc.heap.end(), cmp);
+    };
+
+    for (int o : origins) {
+        if (o >= 0 && o < n) relax(o, 0, 0.0);
+    }
+
+    while (!sc.heap.empty()) {
+        std::pop_heap(sc.heap.begin(), sc.heap.end(), cmp);
+        IsochroneScratch::Entry e = sc.heap.back();
+        sc.heap.pop_back();
+        if (sc.best[static_cast<size_t>(e.node) * width + e.legs] < e.km) continue;
+
+        if (e.legs > 0 && e.km < sc.nodeKm[e.node]) {
+            if (sc.nodeKm[e.node] == INF) sc.reached.push_back(e.node);
+            sc.nodeKm[e.node] = e.km;
+            sc.nodeStops[e.node] = e.legs - 1;
+        }
+        if (e.legs == maxLegs) continue;
+
+        for (int i = g.outStart[e.node]; i < g.outStart[e.node + 1]; ++i) {
+            double km = e.km + g.outKm[i];
+            if (km <= maxKm) relax(g.outAdj[i], e.legs + 1, km);
+        }
+    }
+
+    // origins themselves are not reported as hits
+    for (int node : sc.reached) {
+        if (std::find(origins.begin(), origins.end(), node) == origins.end()) {
+            out.push_back({ node, sc.nodeKm[node], sc.nodeStops[node] });
+        }
+        sc.nodeKm[node] = INF;
+    }
+    for (int idx : sc.touched) sc.best[idx] = INF;
+
+    std::sort(out.begin(), out.end(),
+              [](const IsochroneHit& a, const IsochroneHit& b) {
+                  if (a.km == b.km) return a.node < b.node;
+                  return a.km < b.km;
+              });
+}
+
+// ---------- Background Analytics ----------
+
+// Rebuilds derived indexes whenever the dataset version moves on.
+bool analyticsStopping = false;   // guarded by analyticsMutex
+
+void analyticsWorker() {
+    uint64_t built = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(analyticsMutex);
+            analyticsCv.wait(lk, [&]{ return analyticsStopping || datasetVersion.load() != built; });
+            if (analyticsStopping) return;
+        }
+        // let a burst of mutations settle before rebuilding
+        if (built != 0) std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+        std::shared_ptr<const RouteGraph> graph;
+        {
+            TraceSpan span("analytics.routeGraph");
+            graph = routeGraphSnapshot();
+        }
+        built = graph->version;
+
+        if (hopMatrixEnabled) {
+            TraceSpan span("analytics.hopMatrix");
+            auto start = std::chrono::steady_clock::now();
+            std::atomic_store(&hopMatrix, computeHopMatrix(graph));
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            std::cerr << "Hop matrix built for " << graph->nodeCount()
+                      << " airports in " << ms << " ms (version " << built << ").\n";
+        }
+
+        if (centralityEnabled) {
+            TraceSpan span("analytics.centrality");
+            auto report = computeCentrality(graph);
+            std::atomic_store(&centralityReport, report);
+            std::cerr << "Centrality computed in " << report->computeMs
+                      << " ms (version " << built << ").\n";
+        }
+    }
+}
+
+void stopAnalyticsWorker() {
+    {
+        std::lock_guard<std::mutex> lk(analyticsMutex);
+        analyticsStopping = true;
+    }
+    analyticsCv.notify_all();
+}
+
+// ---------- Dataset Loading ----------
+
+std::atomic<bool> reloadRunning{false};  // startReload() thread in flight
+std::mutex reloadStatusMutex;
+ReloadStatus lastReload;                 // guarded by reloadStatusMutex
+
+namespace {
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+void noteReloadFailure(const std::string& message, std::string* error) {
+    std::cerr << "Dataset load failed: " << message << "\n";
+    if (error) *error = message;
+    std::lock_guard<std::mutex> lk(reloadStatusMutex);
+    lastReload.failures += 1;
+    lastReload.lastError = message;
+}
+
+} // namespace
+
+bool loadDataset(const std::string& dir, std::string* error) {
+    std::lock_guard<std::mutex> serial(reloadMutex);
+    TraceSpan span("dataset.load");
+    auto start = std::chrono::steady_clock::now();
+
+    // the three files are independent tables; only the string pool is shared
+    auto staged = std::make_unique<Dataset>();
+    std::mutex poolLock;
+    auto airlinesOk = std::async(std::launch::async, [&] {
+        return loadAirlines(*staged, dir + "/airlines.dat", &poolLock);
+    });
+    auto airportsOk = std::async(std::launch::async, [&] {
+        return loadAirports(*staged, dir + "/airports.dat", &poolLock);
+    });
+    std::string routesError;
+    bool routesOk = loadRoutes(*staged, dir + "/routes.dat", &poolLock, &routesError);
+    bool ok[] = { airlinesOk.get(), airportsOk.get(), routesOk };
+    const char* files[] = { "airlines.dat", "airports.dat", "routes.dat" };
+    size_t rows[] = { staged->airlinesById.size(), staged->airportsById.size(), staged->routes.size() };
+    for (int i = 0; i < 3; ++i) {
+        if (i == 2 && !routesError.empty()) {
+            noteReloadFailure(dir + "/" + routesError, error);
+            return false;
+        }
+        if (!ok[i] || rows[i] == 0) {
+            noteReloadFailure(dir + "/" + files[i] + (ok[i] ? " has no rows" : " cannot be read"), error);
+            return false;
+        }
+    }
+
+    // Derived indexes, built against the staged tables. Postings intern
+    // equipment codes, so the graph (which reads airport types) follows them
+    // on the same thread; the others never touch the pool.
+    RoutePostings postings;
+    RouteAggregates aggregates, operated;
+    TimezoneIndex timezones;
+    SpatialIndex spatial;
+    ComponentIndex comps;
+    std::shared_ptr<RouteGraph> graph;
+    auto geo = std::async(std::launch::async, [&] {
+        rebuildSpatialIndex(spatial, *staged);
+        rebuildTimezoneIndex(timezones, *staged);
+    });
+    auto counts = std::async(std::launch::async, [&] {
+        rebuildRouteAggregates(aggregates, operated, *staged);
+    });
+    rebuildRoutePostings(postings, *staged);
+    graph = buildRouteGraph(*staged);
+    rebuildComponents(comps, graph);
+    geo.get();
+    counts.get();
+    double loadMs = elapsedMs(start);
+
+    // Swap everything in at once; readers in flight hold the shared lock, so
+    // the old tables stay valid until they finish.
+    uint64_t version;
+    double swapUs;
+    {
+        TraceSpan swapSpan("dataset.swap");
+        std::unique_lock<std::shared_mutex> lock(dataMutex);
+        auto swapStart = std::chrono::steady_clock::now();
+        swap(liveDataset, *staged);
+        std::swap(routePostings, postings);
+        std::swap(routeAggregates, aggregates);
+        std::swap(operatedAggregates, operated);
+        std::swap(timezoneIndex, timezones);
+        std::swap(spatialIndex, spatial);
+        std::swap(components, comps);
+        markDatasetChanged();
+        version = datasetVersion.load();
+        graph->version = version;
+        std::atomic_store(&cachedRouteGraph, std::shared_ptr<const RouteGraph>(graph));
+        swapUs = elapsedMs(swapStart) * 1000.0;
+    }
+
+    // the old tables and indexes (now in the staged locals) are freed here,
+    // outside the lock
+    staged.reset();
+    {
+        std::shared_lock<std::shared_mutex> lock(dataMutex);
+        currentSuggestIndex();
+    }
+
+    std::cerr << "Dataset loaded from " << dir << " in " << loadMs << " ms (swap "
+              << swapUs << " us, version " << version << ").\n";
+    std::lock_guard<std::mutex> lk(reloadStatusMutex);
+    lastReload.reloads += 1;
+    lastReload.version = version;
+    lastReload.loadMs = loadMs;
+    lastReload.swapUs = swapUs;
+    lastReload.lastError.clear();
+    return true;
+}
+
+bool startReload(const std::string& dir) {
+    bool idle = false;
+    if (!reloadRunning.compare_exchange_strong(idle, true)) return false;
+    std::thread([dir] {
+        loadDataset(dir);
+        reloadRunning = false;
+    }).detach();
+    return true;
+}
+
+ReloadStatus reloadStatus() {
+    std::lock_guard<std::mutex> lk(reloadStatusMutex);
+    ReloadStatus status = lastReload;
+    status.running = reloadRunning.load();
+    return status;
+}
+
+#ifdef __linux__
+
+bool watchDataset(const std::string& dir) {
+    int fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0) return false;
+    if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(fd);
+        return false;
+    }
+
+    std::thread([fd, dir] {
+        alignas(inotify_event) char buf[4096];
+        bool pending = false;
+        for (;;) {
+            // wait for the writes to settle before reloading
+            pollfd pfd{ fd, POLLIN, 0 };
+            int ready = poll(&pfd, 1, pending ? 500 : -1);
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (ready == 0) {
+                pending = !startReload(dir); // retry if a reload is running
+                continue;
+            }
+            ssize_t len = read(fd, buf, sizeof buf);
+            if (len <= 0) break;
+            for (char* p = buf; p < buf + len; ) {
+                const auto* ev = reinterpret_cast<const inotify_event*>(p);
+                std::string_view name = ev->len ? std::string_view(ev->name) : std::string_view();
+                if (name == "airlines.dat" || name == "airports.dat" || name == "routes.dat") pending = true;
+                p += sizeof(inotify_event) + ev->len;
+            }
+        }
+        close(fd);
+    }).detach();
+    return true;
+}
+
+#else
+
+bool watchDataset(const std::string&) {
+    return false;
+}
+
+#endif
+
+// ---------- Queries ----------
+
+// Definitions for the query API declared in engine.h.
+
+// Airlines flying into an airport, sorted by IATA.
+AirlinesForAirportResult queryAirlinesForAirport(const std::string& airportIata) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    AirlinesForAirportResult r;
+    r.version = datasetVersion.load();
+    Airport* ap = getAirportByIata(airportIata);
+    if (!ap) {
+        r.error = "Airport not found";
+        return r;
+    }
+
+    // collect airline IDs that have this airport as destination
+    std::unordered_map<int, bool> airlineIds;
+    int slot = airportSlots.find(ap->id);
+    if (slot >= 0) {
+        forEachEq(routes.dst.data(), nullptr, routes.size(), static_cast<DenseIdx>(slot),
+                  [&](size_t i) { airlineIds[airlineSlots.idOf[routes.airline[i]]] = true; });
+    }
+
+    // build list of airlines
+    std::vector<const Airline*> list;
+    list.reserve(airlineIds.size());
+    for (auto& kv : airlineIds) {
+        auto it = airlinesById.find(kv.first);
+        if (it != airlinesById.end()) {
+            list.push_back(&it->second);
+        }
+    }
+
+    // sort by airline IATA for stable output
+    std::sort(list.begin(), list.end(),
+              [](const Airline* a, const Airline* b) {
+                  return a->iata < b->iata;
+              });
+
+    r.airport = ap->iata;
+    r.airlines.reserve(list.size());
+    for (const Airline* a : list) r.airlines.push_back(airlineRecord(*a));
+    return r;
+}
+
+// Top n destinations for an airline, grouped by city, airport or country.
+TopDestinationsResult queryTopDestinations(const std::string& airlineIata, int n, const std::string& by,
+                                           bool operatedOnly) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    const RouteAggregates& aggregates = aggregatesFor(operatedOnly);
+    TopDestinationsResult r;
+    r.version = datasetVersion.load();
+    Airline* a = getAirlineByIata(airlineIata);
+    if (!a) {
+        r.error = "Airline not found";
+        return r;
+    }
+
+    // rows are (key, route count); key is the city or country StrId,
+    // or the airport ID, depending on the grouping
+    struct Row { int key; int count; };
+    std::vector<Row> rows;
+
+    if (by == "city") {
+        auto agg = aggregates.citiesByAirline.find(a->id);
+        if (agg != aggregates.citiesByAirline.end()) {
+            rows.reserve(agg->second.size());
+            for (auto& kv : agg->second) rows.push_back({ kv.first, kv.second });
+        }
+    } else {
+        auto agg = aggregates.destinationsByAirline.find(a->id);
+        if (agg != aggregates.destinationsByAirline.end()) {
+            if (by == "airport") {
+                rows.reserve(agg->second.size());
+                for (auto& kv : agg->second) {
+                    if (airportsById.count(kv.first)) rows.push_back({ kv.first, kv.second });
+                }
+            } else {
+                // group destination airports by country with dense counters
+                static thread_local std::vector<int> counts;
+                static thread_local std::vector<int> touched;
+                if (counts.size() < strings.size()) counts.resize(strings.size(), 0);
+                touched.clear();
+                for (auto& kv : agg->second) {
+                    auto ap = airportsById.find(kv.first);
+                    if (ap == airportsById.end()) continue;
+                    int k = static_cast<int>(ap->second.country);
+                    if (counts[k] == 0) touched.push_back(k);
+                    counts[k] += kv.second;
+                }
+                rows.reserve(touched.size());
+                for (int k : touched) {
+                    rows.push_back({ k, counts[k] });
+                    counts[k] = 0;
+                }
+            }
+        }
+    }
+
+    auto label = [&by](int key) -> std::string_view {
+        if (by == "airport") return airportsById.at(key).iata;
+        return strings.view(static_cast<StrId>(key));
+    };
+
+    if (n > static_cast<int>(rows.size()))
+        n = static_cast<int>(rows.size());
+    std::partial_sort(rows.begin(), rows.begin() + n, rows.end(),
+                      [&label](const Row& x, const Row& y) {
+                          if (x.count == y.count) return label(x.key) < label(y.key);
+                          return x.count > y.count;
+                      });
+
+    r.airline = a->iata;
+    r.by = by;
+    r.rows.resize(n);
+    for (int i = 0; i < n; ++i) {
+        AirportCount& row = r.rows[i];
+        if (by == "airport") {
+            const Airport& ap = airportsById.at(rows[i].key);
+            row.iata    = ap.iata;
+            row.name    = strings.str(ap.name);
+            row.city    = strings.str(ap.city);
+            row.country = strings.str(ap.country);
+        } else if (by == "city") {
+            row.city = strings.str(static_cast<StrId>(rows[i].key));
+        } else {
+            row.country = strings.str(static_cast<StrId>(rows[i].key));
+        }
+        row.routes = rows[i].count;
+    }
+    return r;
+}
+
+// Great-circle distance between two airports.
+DistanceResult queryDistance(const std::string& srcIata, const std::string& dstIata) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    DistanceResult r;
+    r.version = datasetVersion.load();
+
+    Airport* src = getAirportByIata(srcIata);
+    Airport* dst = getAirportByIata(dstIata);
+
+    if (!src) {
+        r.error = "Source airport not found";
+        return r;
+    }
+    if (!dst) {
+        r.error = "Destination airport not found";
+        return r;
+    }
+
+    r.src = src->iata;
+    r.dst = dst->iata;
+    r.km  = haversineKm(src->latitude, src->longitude, dst->latitude, dst->longitude);
+    return r;
+}
+
+// Every airline, sorted by IATA.
+AirlinesReportResult queryAirlinesReport() {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    std::vector<const Airline*> list;
+    list.reserve(airlinesById.size());
+    for (auto& kv : airlinesById) {
+        list.push_back(&kv.second);
+    }
+
+    std::sort(list.begin(), list.end(),
+              [](const Airline* a, const Airline* b) {
+                  return a->iata < b->iata;
+              });
+
+    AirlinesReportResult r;
+    r.version = datasetVersion.load();
+    r.airlines.reserve(list.size());
+    for (const Airline* a : list) r.airlines.push_back(airlineRecord(*a));
+    return r;
+}
+
+// Every airport, sorted by IATA.
+AirportsReportResult queryAirportsReport() {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    std::vector<const Airport*> list;
+    list.reserve(airportsById.size());
+    for (auto& kv : airportsById) {
+        list.push_back(&kv.second);
+    }
+
+    std::sort(list.begin(), list.end(),
+              [](const Airport* a, const Airport* b) {
+                  return a->iata < b->iata;
+              });
+
+    AirportsReportResult r;
+    r.version = datasetVersion.load();
+    r.airports.reserve(list.size());
+    for (const Airport* ap : list) r.airports.push_back(airportRecord(*ap));
+    return r;
+}
+
+// Airports served by an airline, by descending route count.
+AirlineRoutesReportResult queryAirlineRoutesReport(const std::string& airlineIata, bool operatedOnly) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    const RouteAggregates& aggregates = aggregatesFor(operatedOnly);
+    AirlineRoutesReportResult r;
+    r.version = datasetVersion.load();
+    Airline* airline = getAirlineByIata(airlineIata);
+    if (!airline) {
+        r.error = "Airline not found";
+        return r;
+    }
+
+    struct Row {
+        const Airport* airport;
+        int count;
+    };
+    std::vector<Row> rows;
+    auto agg = aggregates.airportsByAirline.find(airline->id);
+    if (agg != aggregates.airportsByAirline.end()) {
+        rows.reserve(agg->second.size());
+        for (auto& kv : agg->second) {
+            auto it = airportsById.find(kv.first);
+            if (it != airportsById.end()) {
+                rows.push_back({ &it->second, kv.second });
+            }
+        }
+    }
+
+    std::sort(rows.begin(), rows.end(),
+              [](const Row& a, const Row& b) {
+                  if (a.count == b.count) {
+                      return a.airport->iata < b.airport->iata;
+                  }
+                  return a.count > b.count;
+              });
+
+    r.airline = airlineRecord(*airline);
+    r.operatedOnly = operatedOnly;
+    r.airports.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        AirportCount& row = r.airports[i];
+        row.iata    = rows[i].airport->iata;
+        row.name    = strings.str(rows[i].airport->name);
+        row.city    = strings.str(rows[i].airport->city);
+        row.country = strings.str(rows[i].airport->country);
+        row.routes  = rows[i].count;
+    }
+    return r;
+}
+
+// Airlines serving an airport, by descending route count.
+AirportRoutesReportResult queryAirportRoutesReport(const std::string& airportIata, bool operatedOnly) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    const RouteAggregates& aggregates = aggregatesFor(operatedOnly);
+    AirportRoutesReportResult r;
+    r.version = datasetVersion.load();
+    Airport* airport = getAirportByIata(airportIata);
+    if (!airport) {
+        r.error = "Airport not found";
+        return r;
+    }
+
+    struct Row {
+        const Airline* airline;
+        int count;
+    };
+    std::vector<Row> rows;
+    auto agg = aggregates.airlinesByAirport.find(airport->id);
+    if (agg != aggregates.airlinesByAirport.end()) {
+        rows.reserve(agg->second.size());
+        for (auto& kv : agg->second) {
+            auto it = airlinesById.find(kv.first);
+            if (it != airlinesById.end()) {
+                rows.push_back({ &it->second, kv.second });
+            }
+        }
+    }
+
+    std::sort(rows.begin(), rows.end(),
+              [](const Row& a, const Row& b) {
+                  if (a.count == b.count) {
+                      return a.airline->iata < b.airline->iata;
+                  }
+                  return a.count > b.count;
+              });
+
+    r.airport = airportRecord(*airport);
+    r.operatedOnly = operatedOnly;
+    r.airlines.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        AirlineCount& row = r.airlines[i];
+        row.iata    = rows[i].airline->iata;
+        row.name    = strings.str(rows[i].airline->name);
+        row.country = strings.str(rows[i].airline->country);
+        row.routes  = rows[i].count;
+    }
+    return r;
+}
+
+// One-stop connections between two airports, shortest total distance first.
+OneHopResult queryOneHop(const std::string& srcIata, const std::string& dstIata) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    OneHopResult r;
+    r.version = datasetVersion.load();
+
+    Airport* src = getAirportByIata(srcIata);
+    Airport* dst = getAirportByIata(dstIata);
+
+    if (!src) {
+        r.error = "Source airport not found";
+        return r;
+    }
+    if (!dst) {
+        r.error = "Destination airport not found";
+        return r;
+    }
+    r.src = src->iata;
+    r.dst = dst->iata;
+
+    // Different components (or the wrong side of the condensation order)
+    // mean no path at all, so skip the scans
+    if (componentReachability(src->id, dst->id) == 0) return r;
+
+    // Mark airports reachable from src (bit 1) and that can reach
+    // dst (bit 2), by airport slot
+    TraceSpan span("onehop.scan");
+    std::vector<uint8_t> marks(airportSlots.size(), 0);
+    int srcSlot = airportSlots.find(src->id);
+    int dstSlot = airportSlots.find(dst->id);
+    if (srcSlot >= 0) {
+        forEachEq(routes.src.data(), nullptr, routes.size(), static_cast<DenseIdx>(srcSlot),
+                  [&](size_t i) { marks[routes.dst[i]] |= 1; });
+        noteRoutesScanned(routes.size());
+    }
+    if (dstSlot >= 0) {
+        forEachEq(routes.dst.data(), nullptr, routes.size(), static_cast<DenseIdx>(dstSlot),
+                  [&](size_t i) { marks[routes.src[i]] |= 2; });
+        noteRoutesScanned(routes.size());
+    }
+
+    // Find intersection (connecting airports)
+    std::vector<const Airport*> connections;
+    for (size_t slot = 0; slot < marks.size(); ++slot) {
+        if (marks[slot] == 3) {
+            auto it = airportsById.find(airportSlots.idOf[slot]);
+            if (it != airportsById.end() && inRouteGraph(it->second)) {
+                connections.push_back(&it->second);
+            }
+        }
+    }
+
+    // Calculate distances and sort by total distance
+    span.phase("onehop.rank");
+    struct Connection {
+        const Airport* hub;
+        double leg1_km;
+        double leg2_km;
+        double total_km;
+    };
+
+    std::vector<Connection> results;
+    for (const Airport* hub : connections) {
+        double leg1 = haversineKm(src->latitude, src->longitude, hub->latitude, hub->longitude);
+        double leg2 = haversineKm(hub->latitude, hub->longitude, dst->latitude, dst->longitude);
+        results.push_back({hub, leg1, leg2, leg1 + leg2});
+    }
+
+    // Sort by total distance (ascending)
+    std::sort(results.begin(), results.end(),
+              [](const Connection& a, const Connection& b) {
+                  return a.total_km < b.total_km;
+              });
+
+    span.phase("onehop.build");
+    r.connections.resize(results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        OneHopConnection& c = r.connections[i];
+        c.hubIata = results[i].hub->iata;
+        c.hubName = strings.str(results[i].hub->name);
+        c.hubCity = strings.str(results[i].hub->city);
+        c.leg1Km  = results[i].leg1_km;
+        c.leg2Km  = results[i].leg2_km;
+        c.totalKm = results[i].total_km;
+    }
+    return r;
+}
+
+// Airline by IATA code.
+AirlineResult queryAirline(const std::string& iata) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    AirlineResult r;
+    r.version = datasetVersion.load();
+    Airline* a = getAirlineByIata(iata);
+    if (!a) {
+        r.error = "Airline not found";
+        return r;
+    }
+    r.airline = airlineRecord(*a);
+    return r;
+}
+
+// Airline by 3-character ICAO code.
+AirlineResult queryAirlineByIcao(const std::string& icao) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    AirlineResult r;
+    r.version = datasetVersion.load();
+    Airline* a = getAirlineByIcao(icao);
+    if (!a) {
+        r.error = "Airline not found";
+        return r;
+    }
+    r.airline = airlineRecord(*a);
+    return r;
+}
+
+// Airport by IATA code.
+AirportResult queryAirport(const std::string& iata) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    AirportResult r;
+    r.version = datasetVersion.load();
+    Airport* ap = getAirportByIata(iata);
+    if (!ap) {
+        r.error = "Airport not found";
+        return r;
+    }
+    r.airport = airportRecord(*ap);
+    return r;
+}
+
+// Airport by 4-character ICAO code.
+AirportResult queryAirportByIcao(const std::string& icao) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    AirportResult r;
+    r.version = datasetVersion.load();
+    Airport* ap = getAirportByIcao(icao);
+    if (!ap) {
+        r.error = "Airport not found";
+        return r;
+    }
+    r.airport = airportRecord(*ap);
+    return r;
+}
+
+// Many airport and airline codes at once. Codes are upper-case; 3-letter
+// airport and 2-letter airline codes are IATA, 4/3-letter are ICAO.
+BulkResult queryBulk(const std::vector<std::string>& airportCodes, const std::vector<std::string>& airlineCodes) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    TraceSpan span("bulk.lookup");
+    BulkResult r;
+    r.version = datasetVersion.load();
+    for (const std::string& code : airportCodes) {
+        const Airport* ap = code.size() == AIRPORT_ICAO_LEN ? getAirportByIcao(code) : getAirportByIata(code);
+        if (ap) r.airports.emplace_back(code, airportRecord(*ap));
+        else r.missingAirports.push_back(code);
+    }
+    for (const std::string& code : airlineCodes) {
+        const Airline* a = code.size() == AIRLINE_ICAO_LEN ? getAirlineByIcao(code) : getAirlineByIata(code);
+        if (a) r.airlines.emplace_back(code, airlineRecord(*a));
+        else r.missingAirlines.push_back(code);
+    }
+    return r;
+}
+
+// Typeahead over airports and airlines; kind is "airport", "airline" or ""
+// for both. Exact prefix matches rank first, then by route degree.
+SuggestResult querySuggest(const std::string& query, int k, const std::string& kind, bool fuzzy) {
+    SuggestResult r;
+    std::string q = SuggestIndex::fold(query);
+    q.erase(0, q.find_first_not_of(' '));
+    if (q.empty()) {
+        r.error = "q is required";
+        return r;
+    }
+
+    static const char* fieldNames[] = { "iata", "icao", "name", "city", "callsign" };
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    r.version = datasetVersion.load();
+    TraceSpan span("suggest.lookup");
+    auto index = currentSuggestIndex();
+
+    struct Row {
+        bool airport;
+        SuggestIndex::Hit hit;
+    };
+    std::vector<Row> rows;
+    if (kind != "airline") {
+        for (const auto& h : index->airports.query(q, k, fuzzy)) rows.push_back({ true, h });
+    }
+    if (kind != "airport") {
+        for (const auto& h : index->airlines.query(q, k, fuzzy)) rows.push_back({ false, h });
+    }
+    std::stable_sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+        if (a.hit.fuzzy != b.hit.fuzzy) return !a.hit.fuzzy;
+        return a.hit.degree > b.hit.degree;
+    });
+    if (rows.size() > static_cast<size_t>(k)) rows.resize(k);
+
+    span.phase("suggest.build");
+    r.query = query;
+    r.suggestions.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const SuggestIndex::Hit& h = rows[i].hit;
+        Suggestion& s = r.suggestions[i];
+        s.airport = rows[i].airport;
+        if (s.airport) {
+            const Airport& ap = airportsById.at(h.id);
+            s.iata    = ap.iata;
+            s.icao    = ap.icao;
+            s.name    = strings.str(ap.name);
+            s.city    = strings.str(ap.city);
+            s.country = strings.str(ap.country);
+        } else {
+            const Airline& al = airlinesById.at(h.id);
+            s.iata    = al.iata;
+            s.icao    = al.icao;
+            s.name    = strings.str(al.name);
+            s.country = strings.str(al.country);
+        }
+        s.id      = h.id;
+        s.routes  = h.degree;
+        s.matched = fieldNames[h.field];
+        s.fuzzy   = h.fuzzy;
+    }
+    return r;
+}
+
+// Top airports by betweenness (or PageRank) from the background report.
+CentralityResult queryCentrality(int limit, bool byPageRank) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    CentralityResult r;
+    r.version = datasetVersion.load();
+    auto report = std::atomic_load(&centralityReport);
+    if (!report) {
+        r.error = centralityEnabled ? "Centrality report not ready" : "Centrality report disabled";
+        return r;
+    }
+
+    const RouteGraph& g = *report->graph;
+    const std::vector<double>& key = byPageRank ? report->pagerank : report->betweenness;
+    std::vector<int> nodes(g.nodeCount());
+    for (int i = 0; i < g.nodeCount(); ++i) nodes[i] = i;
+
+    if (limit <= 0 || limit > g.nodeCount()) limit = g.nodeCount();
+    std::partial_sort(nodes.begin(), nodes.begin() + limit, nodes.end(),
+                      [&key](int a, int b) {
+                          if (key[a] == key[b]) return a < b;
+                          return key[a] > key[b];
+                      });
+
+    // normalise betweenness by the number of ordered pairs excluding the node
+    double n = g.nodeCount();
+    double pairs = n > 2 ? (n - 1) * (n - 2) : 1.0;
+
+    r.byPageRank = byPageRank;
+    r.airports.resize(limit);
+    for (int i = 0; i < limit; ++i) {
+        int node = nodes[i];
+        CentralityRow& row = r.airports[i];
+        row.id = g.airportIds[node];
+        auto it = airportsById.find(row.id);
+        if (it != airportsById.end()) {
+            row.known   = true;
+            row.iata    = it->second.iata;
+            row.name    = strings.str(it->second.name);
+            row.city    = strings.str(it->second.city);
+            row.country = strings.str(it->second.country);
+        }
+        row.betweenness = report->betweenness[node];
+        row.betweennessNormalized = report->betweenness[node] / pairs;
+        row.pagerank = report->pagerank[node];
+    }
+
+    r.computeMs = report->computeMs;
+    r.graphVersion = g.version;
+    r.stale = g.version != datasetVersion.load();
+    return r;
+}
+
+// Airports reachable from any origin within maxKm (infinity for no limit)
+// and maxStops.
+IsochroneResult queryIsochrone(const std::vector<std::string>& originIatas, double maxKm, int maxStops) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    IsochroneResult r;
+    r.version = datasetVersion.load();
+    if (maxStops < 0) maxStops = 0;
+    if (maxStops > ISOCHRONE_MAX_STOPS) maxStops = ISOCHRONE_MAX_STOPS;
+    auto g = currentRouteGraph();
+
+    std::vector<int> origins;
+    std::vector<std::string> originCodes;
+    for (const std::string& code : originIatas) {
+        if (code.empty()) continue;
+        Airport* ap = getAirportByIata(code);
+        if (!ap) {
+            r.error = "Airport not found: " + code;
+            return r;
+        }
+        int node = g->node(ap->id);
+        if (node < 0) {
+            r.error = "Airport not in route graph: " + code;
+            return r;
+        }
+        origins.push_back(node);
+        originCodes.push_back(ap->iata);
+    }
+    if (origins.empty()) {
+        r.error = "No origin airports given";
+        return r;
+    }
+
+    std::vector<IsochroneHit> hits;
+    computeIsochrone(*g, origins, maxKm, maxStops, hits);
+
+    r.origins = std::move(originCodes);
+    r.maxKm = maxKm;
+    r.maxStops = maxStops;
+    r.airports.resize(hits.size());
+    for (size_t i = 0; i < hits.size(); ++i) {
+        const Airport& ap = airportsById.at(g->airportIds[hits[i].node]);
+        IsochroneAirport& out = r.airports[i];
+        out.iata       = ap.iata;
+        out.name       = strings.str(ap.name);
+        out.city       = strings.str(ap.city);
+        out.country    = strings.str(ap.country);
+        out.latitude   = ap.latitude;
+        out.longitude  = ap.longitude;
+        out.distanceKm = hits[i].km;
+        out.stops      = hits[i].stops;
+    }
+    return r;
+}
+
+// The k airports nearest to a coordinate.
+NearestResult queryNearest(double lat, double lon, int k) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    NearestResult r;
+    r.version = datasetVersion.load();
+    if (k <= 0) k = 5;
+    if (k > 1000) k = 1000;
+    r.latitude = lat;
+    r.longitude = lon;
+    r.airports = geoAirports(nearestAirports(lat, lon, static_cast<size_t>(k)));
+    return r;
+}
+
+// Airports within km of a coordinate.
+WithinResult queryWithin(double lat, double lon, double km) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    WithinResult r;
+    r.version = datasetVersion.load();
+    km = std::min(km, PI * EARTH_RADIUS_KM);   // half the globe covers everything
+    r.latitude = lat;
+    r.longitude = lon;
+    r.radiusKm = km;
+    r.airports = geoAirports(airportsWithin(lat, lon, km));
+    return r;
+}
+
+// Strongly and weakly connected component of an airport.
+ComponentResult queryComponent(const std::string& iata) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    ComponentResult r;
+    r.version = datasetVersion.load();
+    Airport* ap = getAirportByIata(iata);
+    if (!ap) {
+        r.error = "Airport not found";
+        return r;
+    }
+    int node = components.node(ap->id);
+    if (node < 0) {
+        r.error = "Airport not in component index";
+        return r;
+    }
+
+    r.airport = ap->iata;
+    r.scc = components.sccOf[node];
+    r.sccSize = components.sccSize[r.scc];
+    r.sccTopoRank = components.sccRank[r.scc];
+    r.wcc = components.wccOf[node];
+    r.wccSize = components.wccSize[r.wcc];
+    return r;
+}
+
+// Reachability verdict from the component index alone (-1 when unknown).
+ReachabilityResult queryReachability(const std::string& srcIata, const std::string& dstIata) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    ReachabilityResult r;
+    r.version = datasetVersion.load();
+    Airport* src = getAirportByIata(srcIata);
+    Airport* dst = getAirportByIata(dstIata);
+    if (!src) {
+        r.error = "Source airport not found";
+        return r;
+    }
+    if (!dst) {
+        r.error = "Destination airport not found";
+        return r;
+    }
+
+    r.src = src->iata;
+    r.dst = dst->iata;
+    r.reachable = componentReachability(src->id, dst->id);
+    return r;
+}
+
+// Largest strongly and weakly connected components.
+ComponentsReportResult queryComponentsReport(int limit) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    ComponentsReportResult r;
+    r.version = datasetVersion.load();
+    auto largest = [limit](const std::vector<int>& sizes, std::vector<ComponentSize>& out) {
+        std::vector<int> ids;
+        for (int i = 0; i < static_cast<int>(sizes.size()); ++i) {
+            if (sizes[i] > 0) ids.push_back(i);
+        }
+        int n = std::min(limit > 0 ? limit : 10, static_cast<int>(ids.size()));
+        std::partial_sort(ids.begin(), ids.begin() + n, ids.end(),
+                          [&sizes](int a, int b) {
+                              if (sizes[a] == sizes[b]) return a < b;
+                              return sizes[a] > sizes[b];
+                          });
+        out.resize(n);
+        for (int i = 0; i < n; ++i) out[i] = { ids[i], sizes[ids[i]] };
+        return static_cast<int>(ids.size());
+    };
+
+    r.sccCount = largest(components.sccSize, r.largestScc);
+    r.wccCount = largest(components.wccSize, r.largestWcc);
+    r.airports = static_cast<int>(components.sccOf.size());
+    return r;
+}
+
+// Airports per timezone name, or per UTC offset.
+TimezonesReportResult queryTimezonesReport(bool byOffset) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    TimezonesReportResult r;
+    r.version = datasetVersion.load();
+    r.byOffset = byOffset;
+    if (byOffset) {
+        r.rows.reserve(timezoneIndex.byOffset.size());
+        for (const auto& kv : timezoneIndex.byOffset) {
+            TimezoneRow row;
+            row.utcOffsetMin = static_cast<int16_t>(kv.first);
+            row.airports = static_cast<int>(kv.second.size());
+            r.rows.push_back(std::move(row));
+        }
+        return r;
+    }
+
+    std::vector<std::pair<std::string_view, const std::vector<int>*>> rows;
+    rows.reserve(timezoneIndex.byTz.size());
+    for (const auto& kv : timezoneIndex.byTz) {
+        rows.push_back({ strings.view(kv.first), &kv.second });
+    }
+    std::sort(rows.begin(), rows.end());
+
+    r.rows.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        // a tz name has one standard offset; report the first airport's
+        const Airport& first = airportsById.at(rows[i].second->front());
+        TimezoneRow& row = r.rows[i];
+        row.tz = std::string(rows[i].first);
+        if (!rows[i].first.empty()) row.utcOffsetMin = first.utcOffsetMin;
+        row.dst = first.dst;
+        row.airports = static_cast<int>(rows[i].second->size());
+    }
+    return r;
+}
+
+// Copies the airports of a timezone index bucket, keeping only rows of
+// `type` when it is non-empty.
+void timezoneAirports(TimezoneAirportsResult& r, const std::vector<int>& ids, const std::string& type) {
+    for (int id : ids) {
+        const Airport& ap = airportsById.at(id);
+        if (!type.empty() && strings.view(ap.type) != type) continue;
+        r.airports.push_back(airportRecord(ap));
+    }
+}
+
+// Airports in a tz database zone (e.g. "Europe/Paris").
+TimezoneAirportsResult queryAirportsByTimezone(const std::string& tz, const std::string& type) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    TimezoneAirportsResult r;
+    r.version = datasetVersion.load();
+    r.tz = tz;
+    StrId tzId = 0;
+    if (strings.find(tz, tzId)) {
+        auto it = timezoneIndex.byTz.find(tzId);
+        if (it != timezoneIndex.byTz.end()) timezoneAirports(r, it->second, type);
+    }
+    return r;
+}
+
+// Airports at a standard UTC offset, in hours.
+TimezoneAirportsResult queryAirportsByUtcOffset(double hours, const std::string& type) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    TimezoneAirportsResult r;
+    r.version = datasetVersion.load();
+    int offset = static_cast<int>(std::lround(hours * 60.0));
+    r.byOffset = true;
+    r.utcOffsetHours = offset / 60.0;
+    auto it = timezoneIndex.byOffset.find(offset);
+    if (it != timezoneIndex.byOffset.end()) timezoneAirports(r, it->second, type);
+    return r;
+}
+
+// Routes flown with an aircraft type; empty filters are ignored.
+RoutesByEquipmentResult queryRoutesByEquipment(const std::string& code, const std::string& airlineIata,
+                                               const std::string& srcIata, const std::string& dstIata,
+                                               int limit) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    RoutesByEquipmentResult r;
+    r.version = datasetVersion.load();
+    if (limit <= 0) limit = 100;
+    static const PostingList empty;
+    std::vector<const PostingList*> lists;
+
+    StrId codeId = 0;
+    auto eq = routePostings.byEquipment.end();
+    if (!code.empty() && strings.find(code, codeId)) eq = routePostings.byEquipment.find(codeId);
+    lists.push_back(eq == routePostings.byEquipment.end() ? &empty : &eq->second);
+
+    if (!airlineIata.empty()) {
+        Airline* a = getAirlineByIata(airlineIata);
+        if (!a) {
+            r.error = "Airline not found";
+            return r;
+        }
+        int slot = airlineSlots.find(a->id);
+        bool indexed = slot >= 0 && slot < static_cast<int>(routePostings.byAirline.size());
+        lists.push_back(indexed ? &routePostings.byAirline[slot] : &empty);
+    }
+    const std::pair<const std::string*, bool> airportFilters[] = { { &srcIata, true }, { &dstIata, false } };
+    for (const auto& filter : airportFilters) {
+        if (filter.first->empty()) continue;
+        Airport* ap = getAirportByIata(*filter.first);
+        if (!ap) {
+            r.error = filter.second ? "Source airport not found" : "Destination airport not found";
+            return r;
+        }
+        const auto& index = filter.second ? routePostings.bySrc : routePostings.byDst;
+        int slot = airportSlots.find(ap->id);
+        bool indexed = slot >= 0 && slot < static_cast<int>(index.size());
+        lists.push_back(indexed ? &index[slot] : &empty);
+    }
+
+    PostingList rows = intersectPostings(lists);
+    for (const PostingList* list : lists) noteRoutesScanned(list->size());
+    int n = std::min(limit, static_cast<int>(rows.size()));
+
+    auto iataOfAirport = [](DenseIdx slot) -> std::string {
+        auto it = airportsById.find(airportSlots.idOf[slot]);
+        return it == airportsById.end() ? "" : it->second.iata;
+    };
+    r.equipment = code;
+    r.matched = static_cast<int>(rows.size());
+    r.routes.resize(n);
+    for (int i = 0; i < n; ++i) {
+        uint32_t row = rows[i];
+        RouteRecord& out = r.routes[i];
+        auto al = airlinesById.find(airlineSlots.idOf[routes.airline[row]]);
+        out.airline   = al == airlinesById.end() ? "" : al->second.iata;
+        out.src       = iataOfAirport(routes.src[row]);
+        out.dst       = iataOfAirport(routes.dst[row]);
+        out.stops     = routes.stops[row];
+        out.codeshare = routes.codeshare[row] != 0;
+        out.equipment = strings.str(routes.equipment[row]);
+    }
+    return r;
+}
+
+// Equipment codes by number of routes; limit <= 0 returns all.
+EquipmentReportResult queryEquipmentReport(int limit) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    EquipmentReportResult r;
+    r.version = datasetVersion.load();
+    std::vector<std::pair<StrId, int>> rows;
+    rows.reserve(routePostings.byEquipment.size());
+    for (const auto& kv : routePostings.byEquipment) {
+        if (!kv.second.empty()) rows.push_back({ kv.first, static_cast<int>(kv.second.size()) });
+    }
+    int n = static_cast<int>(rows.size());
+    if (limit > 0 && limit < n) n = limit;
+    std::partial_sort(rows.begin(), rows.begin() + n, rows.end(),
+                      [](const std::pair<StrId, int>& a, const std::pair<StrId, int>& b) {
+                          if (a.second == b.second) return strings.view(a.first) < strings.view(b.first);
+                          return a.second > b.second;
+                      });
+
+    r.codes = static_cast<int>(rows.size());
+    r.equipment.resize(n);
+    for (int i = 0; i < n; ++i) {
+        r.equipment[i].equipment = strings.str(rows[i].first);
+        r.equipment[i].routes    = rows[i].second;
+    }
+    return r;
+}
+
+// Equipment codes an airline flies, with route counts and shares.
+FleetMixResult queryFleetMix(const std::string& airlineIata) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    FleetMixResult r;
+    r.version = datasetVersion.load();
+    Airline* a = getAirlineByIata(airlineIata);
+    if (!a) {
+        r.error = "Airline not found";
+        return r;
+    }
+
+    // count routes per equipment code with dense counters keyed by StrId
+    static thread_local std::vector<int> counts;
+    static thread_local std::vector<StrId> touched;
+    if (counts.size() < strings.size()) counts.resize(strings.size(), 0);
+    touched.clear();
+
+    int total = 0;
+    int slot = airlineSlots.find(a->id);
+    if (slot >= 0 && slot < static_cast<int>(routePostings.byAirline.size())) {
+        noteRoutesScanned(routePostings.byAirline[slot].size());
+        for (uint32_t row : routePostings.byAirline[slot]) {
+            ++total;
+            for (StrId code : routePostings.codesOf(routes.equipment[row])) {
+                if (counts[code] == 0) touched.push_back(code);
+                counts[code] += 1;
+            }
+        }
+    }
+
+    std::vector<std::pair<StrId, int>> rows;
+    rows.reserve(touched.size());
+    for (StrId code : touched) {
+        rows.push_back({ code, counts[code] });
+        counts[code] = 0;
+    }
+    std::sort(rows.begin(), rows.end(),
+              [](const std::pair<StrId, int>& x, const std::pair<StrId, int>& y) {
+                  if (x.second == y.second) return strings.view(x.first) < strings.view(y.first);
+                  return x.second > y.second;
+              });
+
+    r.airline = a->iata;
+    r.routes = total;
+    r.fleet.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        r.fleet[i].equipment = strings.str(rows[i].first);
+        r.fleet[i].routes    = rows[i].second;
+        r.fleet[i].share     = total > 0 ? static_cast<double>(rows[i].second) / total : 0.0;
+    }
+    return r;
+}
+
+// Minimum hop count between two airports from the precomputed matrix;
+// maxStops < 0 skips the within_max_stops verdict.
+HopsResult queryHops(const std::string& srcIata, const std::string& dstIata, int maxStops) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    HopsResult r;
+    r.version = datasetVersion.load();
+    auto m = std::atomic_load(&hopMatrix);
+    if (!m) {
+        r.error = hopMatrixEnabled ? "Hop matrix not ready" : "Hop matrix disabled";
+        return r;
+    }
+
+    Airport* src = getAirportByIata(srcIata);
+    Airport* dst = getAirportByIata(dstIata);
+    if (!src) {
+        r.error = "Source airport not found";
+        return r;
+    }
+    if (!dst) {
+        r.error = "Destination airport not found";
+        return r;
+    }
+
+    fillHopRow(r.hop, *m, src, dst, maxStops);
+    r.graphVersion = m->graph->version;
+    r.stale = m->graph->version != r.version;
+    return r;
+}
+
+// Hop counts for many pairs; each pair is [src, dst].
+HopsBulkResult queryHopsBulk(const std::vector<std::vector<std::string>>& pairs, int maxStops) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    HopsBulkResult r;
+    r.version = datasetVersion.load();
+    auto m = std::atomic_load(&hopMatrix);
+    if (!m) {
+        r.error = hopMatrixEnabled ? "Hop matrix not ready" : "Hop matrix disabled";
+        return r;
+    }
+
+    TraceSpan span("hops.lookup");
+    r.results.resize(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        const std::vector<std::string>& p = pairs[i];
+        HopRow& out = r.results[i];
+        if (p.size() != 2) {
+            out.hasCodes = false;
+            out.error = "Pair must be [src, dst]";
+            continue;
+        }
+        Airport* src = getAirportByIata(p[0]);
+        Airport* dst = getAirportByIata(p[1]);
+        if (!src || !dst) {
+            out.src = p[0];
+            out.dst = p[1];
+            out.error = "Airport not found";
+            continue;
+        }
+        fillHopRow(out, *m, src, dst, maxStops);
+    }
+
+    r.graphVersion = m->graph->version;
+    r.stale = m->graph->version != r.version;
+    return r;
+}
+
+// ---------- Mutations ----------
+
+// Dataset edits behind the write endpoints. Each takes dataMutex's unique
+// lock, keeps the lookup, spatial, timezone, aggregate and component indexes
+// in step, and bumps the dataset version on success.
+
+// Success result; the version is the one the edit produced.
+MutationResult mutationDone(const char* message) {
+    MutationResult r;
+    r.message = message;
+    r.version = datasetVersion.load();
+    return r;
+}
+
+MutationResult addAirline(int id, const AirlineFields& f) {
+    std::unique_lock<std::shared_mutex> lock(dataMutex);
+    MutationResult r;
+    if (airlinesById.find(id) != airlinesById.end()) {
+        r.error = "Airline ID already exists";
+        return r;
+    }
+    if (!f.name || !f.iata) {
+        r.error = "name and iata are required";
+        return r;
+    }
+
+    Airline a;
+    a.id = id;
+    a.iata = *f.iata;
+    a.icao = f.icao.value_or("");
+    a.name = strings.intern(*f.name);
+    a.alias = f.alias ? strings.intern(*f.alias) : 0;
+    a.callsign = f.callsign ? strings.intern(*f.callsign) : 0;
+    a.country = f.country ? strings.intern(*f.country) : 0;
+    a.active = strings.intern(f.active.value_or("Y"));
+
+    airlinesById[a.id] = a;
+    if (!a.iata.empty()) {
+        airlinesByIata[a.iata] = &airlinesById[a.id];
+    }
+    indexAirlineIcao(liveDataset, airlinesById[a.id]);
+
+    markDatasetChanged();
+
+    r = mutationDone("Airline inserted successfully");
+    r.hasId = true;
+    r.id = id;
+    return r;
+}
+
+MutationResult updateAirline(int id, const AirlineFields& f) {
+    std::unique_lock<std::shared_mutex> lock(dataMutex);
+    MutationResult r;
+    auto it = airlinesById.find(id);
+    if (it == airlinesById.end()) {
+        r.error = "Airline ID not found";
+        return r;
+    }
+
+    // Update only fields that are specified
+    Airline& a = it->second;
+    bool reindexIcao = f.icao || f.active;
+    if (reindexIcao) unindexAirlineIcao(liveDataset, a);
+    if (f.name) a.name = strings.intern(*f.name);
+    if (f.alias) a.alias = strings.intern(*f.alias);
+    if (f.icao) a.icao = *f.icao;
+    if (f.callsign) a.callsign = strings.intern(*f.callsign);
+    if (f.country) a.country = strings.intern(*f.country);
+    if (f.active) a.active = strings.intern(*f.active);
+    if (reindexIcao) indexAirlineIcao(liveDataset, a);
+
+    // Handle IATA update - need to update index
+    if (f.iata && *f.iata != a.iata) {
+        if (!a.iata.empty()) {
+            airlinesByIata.erase(a.iata);
+        }
+        a.iata = *f.iata;
+        if (!a.iata.empty()) {
+            airlinesByIata[a.iata] = &a;
+        }
+    }
+
+    markDatasetChanged();
+
+    r = mutationDone("Airline modified successfully");
+    r.hasId = true;
+    r.id = id;
+    return r;
+}
+
+MutationResult removeAirline(int id) {
+    std::unique_lock<std::shared_mutex> lock(dataMutex);
+    MutationResult r;
+    auto it = airlinesById.find(id);
+    if (it == airlinesById.end()) {
+        r.error = "Airline not found";
+        return r;
+    }
+
+    // Remove from IATA and ICAO indexes
+    if (!it->second.iata.empty()) {
+        airlinesByIata.erase(it->second.iata);
+    }
+    unindexAirlineIcao(liveDataset, it->second);
+
+    // Remove routes for this airline
+    eraseRoutes([id](const Route& rt) { return rt.airlineId == id; });
+
+    airlinesById.erase(it);
+    rebuildComponents();
+
+    markDatasetChanged();
+
+    return mutationDone("Airline and associated routes removed");
+}
+
+MutationResult addAirport(int id, const AirportFields& f) {
+    std::unique_lock<std::shared_mutex> lock(dataMutex);
+    MutationResult r;
+    if (airportsById.find(id) != airportsById.end()) {
+        r.error = "Airport ID already exists";
+        return r;
+    }
+    if (!f.name || !f.iata) {
+        r.error = "name and iata are required";
+        return r;
+    }
+
+    Airport ap;
+    ap.id = id;
+    ap.iata = *f.iata;
+    ap.icao = f.icao.value_or("");
+    ap.latitude = f.latitude.value_or(0.0);
+    ap.longitude = f.longitude.value_or(0.0);
+    ap.name = strings.intern(*f.name);
+    ap.city = f.city ? strings.intern(*f.city) : 0;
+    ap.country = f.country ? strings.intern(*f.country) : 0;
+    applyAirportTimeFields(f, ap);
+
+    airportsById[ap.id] = ap;
+    if (!ap.iata.empty()) {
+        airportsByIata[ap.iata] = &airportsById[ap.id];
+    }
+    indexAirportIcao(liveDataset, airportsById[ap.id]);
+    componentsOnAirportAdded(ap.id);
+    moveAggregatedCity(ap.id, -1, static_cast<int>(ap.city));
+    spatialIndex.insert(airportsById[ap.id]);
+    timezoneIndex.insert(ap);
+
+    markDatasetChanged();
+
+    r = mutationDone("Airport inserted successfully");
+    r.hasId = true;
+    r.id = id;
+    return r;
+}
+
+MutationResult updateAirport(int id, const AirportFields& f) {
+    std::unique_lock<std::shared_mutex> lock(dataMutex);
+    MutationResult r;
+    auto it = airportsById.find(id);
+    if (it == airportsById.end()) {
+        r.error = "Airport ID not found";
+        return r;
+    }
+
+    // Update only fields that are specified
+    Airport& ap = it->second;
+    if (f.name) ap.name = strings.intern(*f.name);
+    if (f.city) {
+        StrId newCity = strings.intern(*f.city);
+        moveAggregatedCity(ap.id, static_cast<int>(ap.city), static_cast<int>(newCity));
+        ap.city = newCity;
+    }
+    if (f.country) ap.country = strings.intern(*f.country);
+    if (f.icao) {
+        unindexAirportIcao(liveDataset, ap);
+        ap.icao = *f.icao;
+        indexAirportIcao(liveDataset, ap);
+    }
+    if (f.latitude) ap.latitude = *f.latitude;
+    if (f.longitude) ap.longitude = *f.longitude;
+    if (f.latitude || f.longitude) spatialIndex.insert(ap);
+
+    bool wasInGraph = inRouteGraph(ap);
+    timezoneIndex.remove(ap);
+    applyAirportTimeFields(f, ap);
+    timezoneIndex.insert(ap);
+    if (inRouteGraph(ap) != wasInGraph) rebuildComponents();
+
+    // Handle IATA update - need to update index
+    if (f.iata && *f.iata != ap.iata) {
+        if (!ap.iata.empty()) {
+            airportsByIata.erase(ap.iata);
+        }
+        ap.iata = *f.iata;
+        if (!ap.iata.empty()) {
+            airportsByIata[ap.iata] = &ap;
+        }
+    }
+
+    markDatasetChanged();
+
+    r = mutationDone("Airport modified successfully");
+    r.hasId = true;
+    r.id = id;
+    return r;
+}
+
+MutationResult removeAirport(int id) {
+    std::unique_lock<std::shared_mutex> lock(dataMutex);
+    MutationResult r;
+    auto it = airportsById.find(id);
+    if (it == airportsById.end()) {
+        r.error = "Airport not found";
+        return r;
+    }
+
+    // Remove from IATA and ICAO indexes
+    if (!it->second.iata.empty()) {
+        airportsByIata.erase(it->second.iata);
+    }
+    unindexAirportIcao(liveDataset, it->second);
+
+    // Remove routes to/from this airport
+    eraseRoutes([id](const Route& rt) { return rt.srcAirportId == id || rt.dstAirportId == id; });
+
+    spatialIndex.remove(id);
+    timezoneIndex.remove(it->second);
+    airportsById.erase(it);
+    rebuildComponents();
+
+    markDatasetChanged();
+
+    return mutationDone("Airport and associated routes removed");
+}
+
+MutationResult addRoute(const RouteFields& f) {
+    std::unique_lock<std::shared_mutex> lock(dataMutex);
+    MutationResult r;
+    Route rt;
+    rt.airlineId = f.airlineId;
+    rt.srcAirportId = f.srcAirportId;
+    rt.dstAirportId = f.dstAirportId;
+    rt.stops = f.stops;
+    rt.codeshare = f.codeshare;
+
+    // Validate foreign keys
+    if (airlinesById.find(rt.airlineId) == airlinesById.end()) {
+        r.error = "Invalid airline ID";
+        return r;
+    }
+    if (airportsById.find(rt.srcAirportId) == airportsById.end()) {
+        r.error = "Invalid source airport ID";
+        return r;
+    }
+    if (airportsById.find(rt.dstAirportId) == airportsById.end()) {
+        r.error = "Invalid destination airport ID";
+        return r;
+    }
+    rt.equipment = f.equipment ? strings.intern(*f.equipment) : 0;
+
+    if (!insertRoute(rt)) {
+        r.error = "Route store is full";
+        return r;
+    }
+    componentsOnRouteAdded(rt);
+
+    markDatasetChanged();
+
+    return mutationDone("Route inserted successfully");
+}
+
+MutationResult removeRoute(int airlineId, int srcAirportId, int dstAirportId) {
+    std::unique_lock<std::shared_mutex> lock(dataMutex);
+    MutationResult r;
+    size_t removed = eraseRoutes(
+        [airlineId, srcAirportId, dstAirportId](const Route& rt) {
+            return rt.airlineId == airlineId &&
+                   rt.srcAirportId == srcAirportId &&
+                   rt.dstAirportId == dstAirportId;
+        });
+
+    if (removed == 0) {
+        r.error = "Route not found";
+        return r;
+    }
+    componentsOnRouteRemoved(srcAirportId, dstAirportId);
+
+    markDatasetChanged();
+
+    return mutationDone("Route removed");
+}
@@ -0,0 +1,1004 @@
+// Flight data engine: the OpenFlights tables, their indexes and the query
+// and mutation functions behind the HTTP API, with no dependency on the
+// server. app.cpp is a thin Crow adapter over it; offline tools link the
+// same library (see Makefile) and call it in-process, e.g.
+//
+//   loadDataset("data");
+//   OneHopResult r = queryOneHop("SFO", "JFK");
+//
+// Results are plain structs; the entry points take dataMutex themselves.
+
+#pragma once
+#include <cctype>
+#include <cerrno>
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <deque>
+#include <list>
+#include <map>
+#include <functional>
+#include <future>
+#include <optional>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ROUTE_KERNELS_SSE2 1
+#endif
+
+// ---------- Constants ----------
+
+const double PI = 3.14159265358979323846;
+
+// ---------- String Pool ----------
+
+// Append-only interning arena. Repeated text fields (cities, countries,
+// names, ...) are stored once and referenced by a 32-bit handle, so equal
+// strings compare and group by handle. Handle 0 is the empty string.
+// Mutated only during load or under dataMutex's unique lock.
+using StrId = uint32_t;
+
+class StringPool {
+public:
+    StringPool() { intern(""); }
+
+    StrId intern(std::string_view s) {
+        auto it = ids_.find(s);
+        if (it != ids_.end()) return it->second;
+
+        // copy into the arena (null-terminated); blocks never move
+        size_t need = s.size() + 1;
+        if (blocks_.empty() || blockUsed_ + need > blockSize_) {
+            size_t size = std::max(BLOCK_BYTES, need);
+            blocks_.emplace_back(new char[size]);
+            blockSize_ = size;
+            blockUsed_ = 0;
+        }
+        char* dst = blocks_.back().get() + blockUsed_;
+        std::copy(s.begin(), s.end(), dst);
+        dst[s.size()] = '\0';
+        blockUsed_ += need;
+        arenaBytes_ += need;
+
+        StrId id = static_cast<StrId>(views_.size());
+        views_.emplace_back(dst, s.size());
+        ids_.emplace(views_.back(), id);
+        return id;
+    }
+
+    // Read-only lookup; safe under a shared lock where intern() is not.
+    bool find(std::string_view s, StrId& out) const {
+        auto it = ids_.find(s);
+        if (it == ids_.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    std::string_view view(StrId id) const { return views_[id]; }
+    const char* str(StrId id) const { return views_[id].data(); }
+    size_t size() const { return views_.size(); }
+    size_t arenaBytes() const { return arenaBytes_; }
+
+private:
+    static constexpr size_t BLOCK_BYTES = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t blockSize_ = 0;
+    size_t blockUsed_ = 0;
+    size_t arenaBytes_ = 0;
+    std::vector<std::string_view> views_;
+    std::unordered_map<std::string_view, StrId> ids_;
+};
+
+
+
+// ---------- Data Structures ----------
+
+struct Airline {
+    int id = -1;
+    StrId name     = 0;
+    StrId alias    = 0;
+    std::string iata;
+    std::string icao;
+    StrId callsign = 0;
+    StrId country  = 0;
+    StrId active   = 0;
+};
+
+const int16_t UTC_OFFSET_UNKNOWN = std::numeric_limits<int16_t>::min();
+
+struct Airport {
+    int id = -1;
+    StrId name    = 0;
+    StrId city    = 0;
+    StrId country = 0;
+    std::string iata;
+    std::string icao;
+    double latitude  = 0.0;
+    double longitude = 0.0;
+    int16_t altitudeFt   = 0;
+    int16_t utcOffsetMin = UTC_OFFSET_UNKNOWN;  // minutes east of UTC
+    char dst      = 'U';   // DST rule: E, A, S, O, Z, N or U (unknown)
+    StrId tz      = 0;     // tz database name, e.g. "America/Los_Angeles"
+    StrId type    = 0;     // airport, station, port or unknown
+    StrId source  = 0;     // OurAirports, Legacy, User
+};
+
+struct Route {
+    int airlineId    = -1;
+    int srcAirportId = -1;
+    int dstAirportId = -1;
+    int stops        = 0;
+    bool codeshare   = false;
+    StrId equipment  = 0;     // raw equipment field, e.g. "CR2 737"
+};
+
+// ---------- Columnar Route Store ----------
+
+// Airport and airline IDs are narrowed to 16-bit dense slots for the route
+// columns. Once no route row refers to a slot any more it goes on a free list
+// and is handed to the next new ID, so the 65536-slot limit caps the IDs in
+// use at one time, not the adds over the server's lifetime.
+using DenseIdx = uint16_t;
+
+struct DenseIndex {
+    static const int FREE_SLOT = -1;      // idOf entry of a released slot
+
+    std::unordered_map<int, DenseIdx> slotOf;
+    std::vector<int> idOf;               // slot -> ID, FREE_SLOT if released
+    std::vector<DenseIdx> freeSlots;
+
+    // -1 if the ID has no slot
+    int find(int id) const {
+        auto it = slotOf.find(id);
+        return it == slotOf.end() ? -1 : it->second;
+    }
+
+    // -1 once all 65536 slots are in use
+    int assign(int id) {
+        auto it = slotOf.find(id);
+        if (it != slotOf.end()) return it->second;
+        DenseIdx slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            idOf[slot] = id;
+        } else {
+            if (idOf.size() > std::numeric_limits<DenseIdx>::max()) return -1;
+            slot = static_cast<DenseIdx>(idOf.size());
+            idOf.push_back(id);
+        }
+        slotOf[id] = slot;
+        return slot;
+    }
+
+    // Frees every assigned slot whose used[] entry is 0.
+    void releaseUnused(const std::vector<uint8_t>& used) {
+        for (size_t slot = 0; slot < idOf.size(); ++slot) {
+            if (used[slot] || idOf[slot] == FREE_SLOT) continue;
+            slotOf.erase(idOf[slot]);
+            idOf[slot] = FREE_SLOT;
+            freeSlots.push_back(static_cast<DenseIdx>(slot));
+        }
+    }
+
+    // slots handed out so far, free ones included; bounds slot-indexed arrays
+    size_t size() const { return idOf.size(); }
+    size_t inUse() const { return idOf.size() - freeSlots.size(); }
+    // slots assign() can still hand to new IDs
+    size_t available() const {
+        return freeSlots.size() + (size_t(std::numeric_limits<DenseIdx>::max()) + 1 - idOf.size());
+    }
+};
+
+// Calls fn(i) for every row i with a[i] == v, or b[i] == v when b is given.
+// SSE2 compares eight 16-bit slots per step; the tail runs scalar.
+template <typename Fn>
+void forEachEq(const DenseIdx* a, const DenseIdx* b, size_t n, DenseIdx v, Fn fn) {
+    size_t i = 0;
+#ifdef ROUTE_KERNELS_SSE2
+    const __m128i needle = _mm_set1_epi16(static_cast<short>(v));
+    for (; i + 8 <= n; i += 8) {
+        __m128i eq = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), needle);
+        if (b) {
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)), needle));
+        }
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        while (mask) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            fn(i + bit / 2);
+            mask &= ~(3u << bit); // two mask bits per 16-bit lane
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        if (a[i] == v || (b && b[i] == v)) fn(i);
+    }
+}
+
+// Routes as parallel columns (structure of arrays). Equality filters scan a
+// single 2-byte column instead of whole Route records; operator[] and the
+// iterator materialize a Route with the original IDs for generic code. The
+// store owns the slot indexes its columns refer to.
+class RouteStore {
+public:
+    DenseIndex airlineSlots;
+    DenseIndex airportSlots;
+
+    std::vector<DenseIdx> airline;
+    std::vector<DenseIdx> src;
+    std::vector<DenseIdx> dst;
+    std::vector<uint8_t> stops;
+    std::vector<uint8_t> codeshare;
+    std::vector<StrId> equipment;
+
+    size_t size() const { return airline.size(); }
+
+    // false when a dense index is out of slots; nothing is assigned then
+    bool push_back(const Route& r) {
+        size_t newAirports = (airportSlots.find(r.srcAirportId) < 0) +
+            (r.dstAirportId != r.srcAirportId && airportSlots.find(r.dstAirportId) < 0);
+        if (airlineSlots.find(r.airlineId) < 0 && airlineSlots.available() == 0) return false;
+        if (newAirports > airportSlots.available()) return false;
+        int a = airlineSlots.assign(r.airlineId);
+        int s = airportSlots.assign(r.srcAirportId);
+        int d = airportSlots.assign(r.dstAirportId);
+        airline.push_back(static_cast<DenseIdx>(a));
+        src.push_back(static_cast<DenseIdx>(s));
+        dst.push_back(static_cast<DenseIdx>(d));
+        stops.push_back(static_cast<uint8_t>(std::max(0, std::min(r.stops, 255))));
+        codeshare.push_back(r.codeshare ? 1 : 0);
+        equipment.push_back(r.equipment);
+        return true;
+    }
+
+    Route operator[](size_t i) const {
+        Route r;
+        r.airlineId    = airlineSlots.idOf[airline[i]];
+        r.srcAirportId = airportSlots.idOf[src[i]];
+        r.dstAirportId = airportSlots.idOf[dst[i]];
+        r.stops        = stops[i];
+        r.codeshare    = codeshare[i] != 0;
+        r.equipment    = equipment[i];
+        return r;
+    }
+
+    // Returns slots no row refers to any more to the free lists. Call after
+    // eraseIf, before rebuilding anything indexed by slot.
+    void releaseUnusedSlots() {
+        std::vector<uint8_t> usedAirline(airlineSlots.size(), 0);
+        std::vector<uint8_t> usedAirport(airportSlots.size(), 0);
+        for (size_t i = 0; i < size(); ++i) {
+            usedAirline[airline[i]] = 1;
+            usedAirport[src[i]] = 1;
+            usedAirport[dst[i]] = 1;
+        }
+        airlineSlots.releaseUnused(usedAirline);
+        airportSlots.releaseUnused(usedAirport);
+    }
+
+    // Removes rows matching pred(const Route&), compacting every column.
+    template <typename Pred>
+    size_t eraseIf(Pred pred) {
+        size_t n = size(), w = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (pred((*this)[i])) continue;
+            if (w != i) {
+                airline[w]   = airline[i];
+                src[w]       = src[i];
+                dst[w]       = dst[i];
+                stops[w]     = stops[i];
+                codeshare[w] = codeshare[i];
+                equipment[w] = equipment[i];
+            }
+            ++w;
+        }
+        airline.resize(w);
+        src.resize(w);
+        dst.resize(w);
+        stops.resize(w);
+        codeshare.resize(w);
+        equipment.resize(w);
+        return n - w;
+    }
+
+    struct const_iterator {
+        const RouteStore* store;
+        size_t i;
+        Route operator*() const { return (*store)[i]; }
+        const_iterator& operator++() { ++i; return *this; }
+        bool operator!=(const const_iterator& o) const { return i != o.i; }
+    };
+    const_iterator begin() const { return { this, 0 }; }
+    const_iterator end() const { return { this, size() }; }
+};
+
+// ---------- Global Storage ----------
+
+// The loaded tables. One live instance backs the names below; a reload builds
+// a second instance off to the side and swaps it in (see loadDataset).
+struct Dataset {
+    StringPool strings;
+
+    // airlines
+    std::unordered_map<int, Airline> airlinesById;
+    std::unordered_map<std::string, Airline*> airlinesByIata;
+    std::unordered_map<uint32_t, Airline*> airlinesByIcao;   // packed 3-char key
+
+    // airports
+    std::unordered_map<int, Airport> airportsById;
+    std::unordered_map<std::string, Airport*> airportsByIata;
+    std::unordered_map<uint32_t, Airport*> airportsByIcao;   // packed 4-char key
+
+    // routes
+    RouteStore routes;
+};
+
+// Exchanges every table; pointers into the maps stay valid.
+void swap(Dataset& a, Dataset& b);
+
+extern Dataset liveDataset;
+
+extern StringPool& strings;
+extern std::unordered_map<int, Airline>& airlinesById;
+extern std::unordered_map<std::string, Airline*>& airlinesByIata;
+extern std::unordered_map<uint32_t, Airline*>& airlinesByIcao;
+extern std::unordered_map<int, Airport>& airportsById;
+extern std::unordered_map<std::string, Airport*>& airportsByIata;
+extern std::unordered_map<uint32_t, Airport*>& airportsByIcao;
+extern RouteStore& routes;
+extern DenseIndex& airportSlots;
+extern DenseIndex& airlineSlots;
+
+// ---------- Dataset Versioning ----------
+
+// Readers take a shared lock, mutations take a unique lock and bump the
+// version so derived indexes and cached results know they are out of date.
+// The query and mutation entry points lock it themselves; hold it only to
+// read the tables above directly.
+extern std::shared_mutex dataMutex;
+extern std::atomic<uint64_t> datasetVersion;
+
+void markDatasetChanged();
+
+// false when the variable is set to 0, false, off or no
+bool envEnabled(const char* name, bool fallback);
+
+// ---------- Tracing ----------
+
+// Span recorder for hot paths. Each thread appends completed spans to its own
+// fixed ring (single writer, newest events overwrite the oldest); the admin
+// dump copies the rings out as Chrome trace JSON. When tracing is off a span
+// costs one relaxed load and a branch.
+extern std::atomic<bool> tracingEnabled;
+
+const size_t TRACE_RING_EVENTS = 8192;   // per thread, power of two
+
+// trace timestamps count from process start
+extern const std::chrono::steady_clock::time_point traceOrigin;
+
+uint64_t traceNowNs();
+// Appends a completed span to the calling thread's ring.
+void recordTraceEvent(const char* name, uint64_t startNs, uint64_t endNs);
+
+// Per-request phase timings and scan counts for the slow-query log. Active
+// only between the metrics middleware's before/after hooks while the log is
+// enabled; spans and scan counters feed it on the worker's own thread.
+struct RequestProfile {
+    static const size_t MAX_PHASES = 16;
+    struct Phase {
+        const char* name;
+        uint64_t durNs;
+    };
+
+    bool active = false;
+    uint64_t routesScanned = 0;
+    size_t phaseCount = 0;
+    Phase phases[MAX_PHASES];
+
+    void begin() {
+        active = true;
+        routesScanned = 0;
+        phaseCount = 0;
+    }
+
+    void addPhase(const char* name, uint64_t durNs) {
+        if (phaseCount < MAX_PHASES) phases[phaseCount++] = { name, durNs };
+    }
+};
+
+extern thread_local RequestProfile requestProfile;
+
+void noteRoutesScanned(size_t rows);
+
+// Times a scope; phase() closes the current span and opens the next one, so
+// a handler can mark lookup/compute/serialize without nesting blocks. Spans go
+// to the trace rings and/or the current request profile.
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name) {
+        trace_ = tracingEnabled.load(std::memory_order_relaxed);
+        if (!trace_ && !requestProfile.active) return;
+        name_ = name;
+        start_ = traceNowNs();
+    }
+    ~TraceSpan() { end(); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    void phase(const char* name) {
+        if (!name_) return;
+        uint64_t now = traceNowNs();
+        finish(now);
+        name_ = name;
+        start_ = now;
+    }
+
+    void end() {
+        if (!name_) return;
+        finish(traceNowNs());
+        name_ = nullptr;
+    }
+
+private:
+    void finish(uint64_t now) {
+        if (trace_) recordTraceEvent(name_, start_, now);
+        if (requestProfile.active) requestProfile.addPhase(name_, now - start_);
+    }
+
+    const char* name_ = nullptr;
+    uint64_t start_ = 0;
+    bool trace_ = false;
+};
+
+// Chrome trace JSON (chrome://tracing, Perfetto) of the recorded spans;
+// clear drops them afterwards.
+std::string renderChromeTrace(bool clear);
+
+// Number of threads that have recorded at least one span.
+size_t traceThreadCount();
+
+// ---------- JSON Writer ----------
+
+// Appends JSON straight into one buffer, skipping the wvalue tree; used for
+// large responses that would otherwise be built and then dumped.
+class JsonWriter {
+public:
+    explicit JsonWriter(size_t reserve = 0) { out_.reserve(reserve); }
+
+    JsonWriter& beginObject() { separate(); out_ += '{'; comma_ = false; return *this; }
+    JsonWriter& endObject() { out_ += '}'; comma_ = true; return *this; }
+    JsonWriter& beginArray() { separate(); out_ += '['; comma_ = false; return *this; }
+    JsonWriter& endArray() { out_ += ']'; comma_ = true; return *this; }
+
+    JsonWriter& key(std::string_view k) {
+        separate();
+        quoted(k);
+        out_ += ':';
+        comma_ = false;
+        return *this;
+    }
+
+    JsonWriter& value(std::string_view v) { separate(); quoted(v); comma_ = true; return *this; }
+    JsonWriter& value(const char* v) { return value(std::string_view(v)); }
+    JsonWriter& value(const std::string& v) { return value(std::string_view(v)); }
+    JsonWriter& value(int v) { separate(); out_ += std::to_string(v); comma_ = true; return *this; }
+    JsonWriter& value(uint64_t v) { separate(); out_ += std::to_string(v); comma_ = true; return *this; }
+    JsonWriter& value(bool v) { separate(); out_ += v ? "true" : "false"; comma_ = true; return *this; }
+    JsonWriter& null() { separate(); out_ += "null"; comma_ = true; return *this; }
+    // Already-serialised JSON (a number or a nested document).
+    JsonWriter& raw(std::string_view json) { separate(); out_ += json; comma_ = true; return *this; }
+
+    JsonWriter& fixed(double v, int decimals) {
+        char buf[48];
+        std::snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+        return raw(buf);
+    }
+
+    JsonWriter& value(double v) {
+        separate();
+        if (std::isnan(v) || std::isinf(v)) {
+            out_ += "null";
+        } else {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.*g", DBL_DECIMAL_DIG, v);
+            out_ += buf;
+        }
+        comma_ = true;
+        return *this;
+    }
+
+    template <typename T>
+    JsonWriter& field(std::string_view k, const T& v) { return key(k).value(v); }
+
+    const std::string& str() const { return out_; }
+    std::string take() { return std::move(out_); }
+
+private:
+    void separate() {
+        if (comma_) out_ += ',';
+    }
+
+    void quoted(std::string_view s) {
+        static const char hex[] = "0123456789abcdef";
+        out_ += '"';
+        for (char c : s) {
+            switch (c) {
+                case '"': out_ += "\\\""; break;
+                case '\\': out_ += "\\\\"; break;
+                case '\n': out_ += "\\n"; break;
+                case '\r': out_ += "\\r"; break;
+                case '\t': out_ += "\\t"; break;
+                case '\b': out_ += "\\b"; break;
+                case '\f': out_ += "\\f"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        out_ += "\\u00";
+                        out_ += hex[(c >> 4) & 0xf];
+                        out_ += hex[c & 0xf];
+                    } else {
+                        out_ += c;
+                    }
+            }
+        }
+        out_ += '"';
+    }
+
+    std::string out_;
+    bool comma_ = false;
+};
+
+// ---------- CSV Helpers ----------
+
+std::vector<std::string> parseCsvLine(const std::string& line);
+bool isNullField(const std::string& s);
+
+// ---------- Lookups ----------
+
+const size_t AIRLINE_ICAO_LEN = 3;
+const size_t AIRPORT_ICAO_LEN = 4;
+
+// nullptr when the code is unknown
+Airline* getAirlineByIata(const std::string& code);
+Airline* getAirlineByIcao(const std::string& code);
+Airport* getAirportByIata(const std::string& code);
+Airport* getAirportByIcao(const std::string& code);
+
+// Haversine distance in kilometers
+double haversineKm(double lat1, double lon1, double lat2, double lon2);
+
+// ---------- Loading ----------
+
+// Append one OpenFlights file to a dataset's tables; false if the file cannot
+// be read. poolLock, when given, guards d.strings so the three loaders can run
+// concurrently. loadDataset() is the usual entry point.
+bool loadAirlines(Dataset& d, const std::string& filename, std::mutex* poolLock = nullptr);
+bool loadAirports(Dataset& d, const std::string& filename, std::mutex* poolLock = nullptr);
+// error is set when the file parses but does not fit the route store
+bool loadRoutes(Dataset& d, const std::string& filename, std::mutex* poolLock = nullptr,
+                std::string* error = nullptr);
+
+// Loads airlines.dat, airports.dat and routes.dat from dir into a fresh
+// dataset, building every derived index off to the side with the files and
+// index builds running in parallel, then swaps it in under a brief unique
+// lock. Readers in flight finish on the old tables, which are freed after the
+// lock is released. Edits made through the mutation API since the last load
+// are replaced. Returns false (live data untouched) if a file is missing or
+// empty; safe to call while the server is running, one load at a time.
+bool loadDataset(const std::string& dir, std::string* error = nullptr);
+
+// Runs loadDataset(dir) on a background thread; false if one is already
+// running.
+bool startReload(const std::string& dir);
+
+struct ReloadStatus {
+    bool running = false;
+    uint64_t reloads = 0;        // successful loads, including the first
+    uint64_t failures = 0;
+    uint64_t version = 0;        // dataset version the last load produced
+    double loadMs = 0;           // files + indexes, off the lock
+    double swapUs = 0;           // time holding the unique lock
+    std::string lastError;
+};
+
+ReloadStatus reloadStatus();
+
+// Reloads when airlines.dat, airports.dat or routes.dat in dir is rewritten
+// or replaced (inotify, Linux only); false if watching is unavailable.
+bool watchDataset(const std::string& dir);
+
+// ---------- Engine Options ----------
+
+// Route graph scope and the optional precomputed reports. The reports are off
+// by default: each dataset change costs a BFS from every airport (hop matrix)
+// and a full Brandes pass (centrality) on analyticsThreads threads.
+struct EngineOptions {
+    bool graphAirportsOnly = false;   // leave stations and ports out of the route graph
+    bool hopMatrix = false;
+    bool centrality = false;
+    unsigned analyticsThreads = 0;    // 0 = half the hardware threads
+};
+
+// Set before loadDataset() and analyticsWorker(); a new graph scope takes
+// effect at the next load.
+void setEngineOptions(const EngineOptions& options);
+EngineOptions engineOptions();
+
+// ---------- Background Analytics ----------
+
+// Rebuilds the hop matrix and centrality report whenever the dataset version
+// moves on. Runs until stopAnalyticsWorker(); start it on its own thread and
+// join it before exit (the globals it reads are destroyed at exit).
+void analyticsWorker();
+void stopAnalyticsWorker();
+
+// The kernels behind the worker, for bench/. routeGraphSnapshot() takes the
+// shared lock; the compute functions read only the immutable graph.
+// recomputeComponents() rebuilds the component index under the unique lock.
+struct RouteGraph;
+struct HopMatrix;
+struct CentralityReport;
+std::shared_ptr<const RouteGraph> routeGraphSnapshot();
+std::shared_ptr<const HopMatrix> computeHopMatrix(std::shared_ptr<const RouteGraph> g);
+std::shared_ptr<const CentralityReport> computeCentrality(std::shared_ptr<const RouteGraph> g);
+void recomputeComponents();
+
+// ---------- Results ----------
+
+// Queries and mutations return plain structs; app.cpp turns them into the
+// endpoints' JSON. A non-empty error means the request was rejected and the
+// other fields are unset. version is the dataset version the result was
+// computed against.
+struct Result {
+    std::string error;
+    uint64_t version = 0;
+
+    bool ok() const { return error.empty(); }
+};
+
+// Copies of table rows, valid after the lock is released.
+struct AirlineRecord {
+    int id = -1;
+    std::string name, alias, iata, icao, callsign, country, active;
+};
+
+struct AirportRecord {
+    int id = -1;
+    std::string name, city, country, iata, icao;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    int altitudeFt = 0;
+    int16_t utcOffsetMin = UTC_OFFSET_UNKNOWN;
+    char dst = 'U';
+    std::string tz, type, source;
+};
+
+// Route count for one airport; the grouping decides which fields are set
+// (city and country rows carry only that column).
+struct AirportCount {
+    std::string iata, name, city, country;
+    int routes = 0;
+};
+
+struct AirlineCount {
+    std::string iata, name, country;
+    int routes = 0;
+};
+
+struct AirlineResult : Result { AirlineRecord airline; };
+struct AirportResult : Result { AirportRecord airport; };
+
+struct BulkResult : Result {
+    std::vector<std::pair<std::string, AirportRecord>> airports;   // by requested code
+    std::vector<std::pair<std::string, AirlineRecord>> airlines;
+    std::vector<std::string> missingAirports, missingAirlines;
+};
+
+struct Suggestion {
+    bool airport = false;        // else an airline, which has no city
+    int id = -1;
+    std::string iata, icao, name, city, country;
+    int routes = 0;
+    const char* matched = "";    // iata, icao, name, city or callsign
+    bool fuzzy = false;
+};
+
+struct SuggestResult : Result {
+    std::string query;
+    std::vector<Suggestion> suggestions;
+};
+
+struct AirlinesForAirportResult : Result {
+    std::string airport;
+    std::vector<AirlineRecord> airlines;
+};
+
+struct TopDestinationsResult : Result {
+    std::string airline, by;
+    std::vector<AirportCount> rows;
+};
+
+struct DistanceResult : Result {
+    std::string src, dst;
+    double km = 0.0;
+};
+
+struct AirlinesReportResult : Result { std::vector<AirlineRecord> airlines; };
+struct AirportsReportResult : Result { std::vector<AirportRecord> airports; };
+
+struct AirlineRoutesReportResult : Result {
+    AirlineRecord airline;
+    std::vector<AirportCount> airports;
+    bool operatedOnly = false;
+};
+
+struct AirportRoutesReportResult : Result {
+    AirportRecord airport;
+    std::vector<AirlineCount> airlines;
+    bool operatedOnly = false;
+};
+
+struct OneHopConnection {
+    std::string hubIata, hubName, hubCity;
+    double leg1Km = 0.0, leg2Km = 0.0, totalKm = 0.0;
+};
+
+struct OneHopResult : Result {
+    std::string src, dst;
+    std::vector<OneHopConnection> connections;   // shortest total first
+};
+
+struct CentralityRow {
+    int id = -1;
+    bool known = false;          // the airport still exists; names set
+    std::string iata, name, city, country;
+    double betweenness = 0.0, betweennessNormalized = 0.0, pagerank = 0.0;
+};
+
+struct CentralityResult : Result {
+    bool byPageRank = false;
+    std::vector<CentralityRow> airports;
+    long long computeMs = 0;
+    uint64_t graphVersion = 0;   // dataset version the report was built from
+    bool stale = false;
+};
+
+struct IsochroneAirport {
+    std::string iata, name, city, country;
+    double latitude = 0.0, longitude = 0.0;
+    double distanceKm = 0.0;
+    int stops = 0;
+};
+
+struct IsochroneResult : Result {
+    std::vector<std::string> origins;
+    double maxKm = 0.0;          // infinity for no limit
+    int maxStops = 0;
+    std::vector<IsochroneAirport> airports;
+};
+
+struct GeoAirport {
+    int id = -1;
+    std::string iata, name, city, country;
+    double latitude = 0.0, longitude = 0.0;
+    double distanceKm = 0.0;
+};
+
+struct NearestResult : Result {
+    double latitude = 0.0, longitude = 0.0;
+    std::vector<GeoAirport> airports;   // nearest first
+};
+
+struct WithinResult : NearestResult { double radiusKm = 0.0; };
+
+struct ComponentResult : Result {
+    std::string airport;
+    int scc = -1, sccSize = 0, sccTopoRank = 0;
+    int wcc = -1, wccSize = 0;
+};
+
+struct ReachabilityResult : Result {
+    std::string src, dst;
+    int reachable = -1;          // 1, 0, or -1 when components alone cannot decide
+};
+
+struct ComponentSize {
+    int id = -1;
+    int size = 0;
+};
+
+struct ComponentsReportResult : Result {
+    int sccCount = 0, wccCount = 0;
+    std::vector<ComponentSize> largestScc, largestWcc;
+    int airports = 0;
+};
+
+struct TimezoneRow {
+    std::string tz;              // empty in the by-offset report
+    int16_t utcOffsetMin = UTC_OFFSET_UNKNOWN;
+    char dst = 'U';
+    int airports = 0;
+};
+
+struct TimezonesReportResult : Result {
+    bool byOffset = false;
+    std::vector<TimezoneRow> rows;
+};
+
+struct TimezoneAirportsResult : Result {
+    bool byOffset = false;
+    std::string tz;
+    double utcOffsetHours = 0.0;
+    std::vector<AirportRecord> airports;
+};
+
+struct RouteRecord {
+    std::string airline, src, dst;   // IATA codes, empty if unknown
+    int stops = 0;
+    bool codeshare = false;
+    std::string equipment;
+};
+
+struct RoutesByEquipmentResult : Result {
+    std::string equipment;
+    std::vector<RouteRecord> routes;   // at most limit rows
+    int matched = 0;                   // rows before the limit
+};
+
+struct EquipmentCount {
+    std::string equipment;
+    int routes = 0;
+    double share = 0.0;          // of the airline's routes (fleet mix only)
+};
+
+struct EquipmentReportResult : Result {
+    std::vector<EquipmentCount> equipment;
+    int codes = 0;               // distinct codes before the limit
+};
+
+struct FleetMixResult : Result {
+    std::string airline;
+    int routes = 0;
+    std::vector<EquipmentCount> fleet;
+};
+
+// One src/dst cell of the hop matrix. A row with an error carries only the
+// codes (or nothing, for a malformed pair).
+struct HopRow {
+    std::string error;
+    bool hasCodes = true;
+    std::string src, dst;
+    int hops = -1;               // -1 when unreachable
+    bool saturated = false;      // hops is a lower bound
+    int maxStops = -1;           // -1 when no verdict was asked for
+    int withinMaxStops = -1;     // 1, 0, or -1 when undecided
+};
+
+struct HopsResult : Result {
+    HopRow hop;
+    uint64_t graphVersion = 0;
+    bool stale = false;
+};
+
+struct HopsBulkResult : Result {
+    std::vector<HopRow> results;
+    uint64_t graphVersion = 0;
+    bool stale = false;
+};
+
+struct MutationResult : Result {
+    std::string message;
+    bool hasId = false;          // inserts and updates echo the ID
+    int id = -1;
+};
+
+// ---------- Queries ----------
+
+// Core computation behind the read endpoints; each takes dataMutex's shared
+// lock. Nothing is cached.
+
+AirlineResult queryAirline(const std::string& iata);
+AirlineResult queryAirlineByIcao(const std::string& icao);
+AirportResult queryAirport(const std::string& iata);
+AirportResult queryAirportByIcao(const std::string& icao);
+// Upper-case codes; 3-letter airport and 2-letter airline codes are IATA,
+// 4/3-letter are ICAO.
+BulkResult queryBulk(const std::vector<std::string>& airportCodes, const std::vector<std::string>& airlineCodes);
+// kind is "airport", "airline" or "" for both.
+SuggestResult querySuggest(const std::string& query, int k, const std::string& kind, bool fuzzy);
+
+AirlinesForAirportResult queryAirlinesForAirport(const std::string& airportIata);
+// by is "city", "airport" or "country".
+TopDestinationsResult queryTopDestinations(const std::string& airlineIata, int n, const std::string& by,
+                                           bool operatedOnly);
+DistanceResult queryDistance(const std::string& srcIata, const std::string& dstIata);
+OneHopResult queryOneHop(const std::string& srcIata, const std::string& dstIata);
+
+AirlinesReportResult queryAirlinesReport();
+AirportsReportResult queryAirportsReport();
+AirlineRoutesReportResult queryAirlineRoutesReport(const std::string& airlineIata, bool operatedOnly);
+AirportRoutesReportResult queryAirportRoutesReport(const std::string& airportIata, bool operatedOnly);
+CentralityResult queryCentrality(int limit, bool byPageRank);
+ComponentsReportResult queryComponentsReport(int limit);
+TimezonesReportResult queryTimezonesReport(bool byOffset);
+EquipmentReportResult queryEquipmentReport(int limit);
+FleetMixResult queryFleetMix(const std::string& airlineIata);
+
+// maxKm = infinity for no distance limit; maxStops is clamped to
+// [0, ISOCHRONE_MAX_STOPS].
+const int ISOCHRONE_MAX_STOPS = 6;
+IsochroneResult queryIsochrone(const std::vector<std::string>& originIatas, double maxKm, int maxStops);
+NearestResult queryNearest(double lat, double lon, int k);
+WithinResult queryWithin(double lat, double lon, double km);
+ComponentResult queryComponent(const std::string& iata);
+ReachabilityResult queryReachability(const std::string& srcIata, const std::string& dstIata);
+// type filters on the airport type column; "" keeps every row.
+TimezoneAirportsResult queryAirportsByTimezone(const std::string& tz, const std::string& type);
+TimezoneAirportsResult queryAirportsByUtcOffset(double hours, const std::string& type);
+// Empty airline/src/dst filters are ignored.
+RoutesByEquipmentResult queryRoutesByEquipment(const std::string& code, const std::string& airlineIata,
+                                               const std::string& srcIata, const std::string& dstIata,
+                                               int limit);
+// maxStops < 0 skips the within_max_stops verdict.
+HopsResult queryHops(const std::string& srcIata, const std::string& dstIata, int maxStops);
+HopsBulkResult queryHopsBulk(const std::vector<std::vector<std::string>>& pairs, int maxStops);
+
+// ---------- Mutations ----------
+
+// Dataset edits behind the write endpoints; each takes dataMutex's unique
+// lock. Unset fields are left as they are by the updates and take their
+// defaults in the inserts, which require name and iata.
+
+struct AirlineFields {
+    std::optional<std::string> name, alias, iata, icao, callsign, country, active;
+};
+
+struct AirportFields {
+    std::optional<std::string> name, city, country, iata, icao;
+    std::optional<double> latitude, longitude;
+    std::optional<int16_t> altitudeFt;
+    std::optional<int16_t> utcOffsetMin;   // UTC_OFFSET_UNKNOWN clears it
+    std::optional<char> dst;
+    std::optional<std::string> tz, type, source;
+};
+
+struct RouteFields {
+    int airlineId = -1;
+    int srcAirportId = -1;
+    int dstAirportId = -1;
+    int stops = 0;
+    bool codeshare = false;
+    std::optional<std::string> equipment;
+};
+
+MutationResult addAirline(int id, const AirlineFields& fields);
+MutationResult updateAirline(int id, const AirlineFields& fields);
+MutationResult removeAirline(int id);
+MutationResult addAirport(int id, const AirportFields& fields);
+MutationResult updateAirport(int id, const AirportFields& fields);
+MutationResult removeAirport(int id);
+MutationResult addRoute(const RouteFields& fields);
+MutationResult removeRoute(int airlineId, int srcAirportId, int dstAirportId);
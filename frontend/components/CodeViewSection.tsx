@@ -4,8 +4,11 @@ import { useState, useEffect } from 'react';
 
 const API_BASE = process.env.NEXT_PUBLIC_API_BASE || 'http://localhost:8080';
 
+type SourceFile = { filename: string; code: string };
+
 export default function CodeViewSection() {
-    const [code, setCode] = useState('');
+    const [files, setFiles] = useState<SourceFile[]>([]);
+    const [selected, setSelected] = useState(0);
     const [loading, setLoading] = useState(true);
     const [error, setError] = useState('');
 
@@ -16,7 +19,8 @@ export default function CodeViewSection() {
                 if (data.error) {
                     setError(data.error);
                 } else {
-                    setCode(data.code);
+                    // older servers send only app.cpp
+                    setFiles(data.files ?? [{ filename: data.filename, code: data.code }]);
                 }
                 setLoading(false);
             })
@@ -43,6 +47,8 @@ export default function CodeViewSection() {
         );
     }
 
+    const file = files[selected] ?? files[0];
+
     return (
         <div className="animate-fade-in">
             <div className="glass-card" style={{ maxWidth: '1000px', margin: '0 auto' }}>
@@ -55,7 +61,7 @@ export default function CodeViewSection() {
                     paddingBottom: 'var(--space-md)'
                 }}>
                     <div>
-                        <h2 style={{ fontSize: '1.5rem', margin: 0 }}>app.cpp</h2>
+                        <h2 style={{ fontSize: '1.5rem', margin: 0 }}>{file?.filename}</h2>
                         <p style={{ color: 'var(--color-text-secondary)', fontSize: '0.9rem', margin: 0 }}>
                             Backend Implementation (fetched from C++ server)
                         </p>
@@ -71,6 +77,20 @@ export default function CodeViewSection() {
                     </div>
                 </div>
 
+                {files.length > 1 && (
+                    <div className="flex" style={{ gap: 'var(--space-sm)', marginBottom: 'var(--space-md)' }}>
+                        {files.map((f, i) => (
+                            <button
+                                key={f.filename}
+                                className={i === selected ? 'btn-primary' : 'btn-secondary'}
+                                onClick={() => setSelected(i)}
+                            >
+                                {f.filename}
+                            </button>
+                        ))}
+                    </div>
+                )}
+
                 <div style={{
                     background: '#1e1e1e',
                     color: '#d4d4d4',
@@ -84,7 +104,7 @@ export default function CodeViewSection() {
                     overflowY: 'auto',
                     whiteSpace: 'pre'
                 }}>
-                    {code}
+                    {file?.code}
                 </div>
             </div>
         </div>
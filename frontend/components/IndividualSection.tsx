@@ -1,7 +1,7 @@
 'use client';
 
-import { useState } from 'react';
-import { fetchAirline, fetchAirport } from '@/lib/api';
+import { useRef, useState } from 'react';
+import { fetchAirline, fetchAirport, fetchSuggestions } from '@/lib/api';
 
 export default function IndividualSection() {
     const [airlineCode, setAirlineCode] = useState('');
@@ -14,6 +14,40 @@ export default function IndividualSection() {
     const [airportError, setAirportError] = useState('');
     const [airportLoading, setAirportLoading] = useState(false);
 
+    const [airlineOptions, setAirlineOptions] = useState<any[]>([]);
+    const [airportOptions, setAirportOptions] = useState<any[]>([]);
+
+    // typeahead: suggest codes while a name, city or code prefix is typed.
+    // Requests wait for a pause in typing, and a response is applied only if
+    // no newer request for the same field was sent after it.
+    const SUGGEST_DELAY_MS = 200;
+    const suggestTimers = useRef<Record<string, ReturnType<typeof setTimeout>>>({});
+    const suggestSeq = useRef<Record<string, number>>({});
+
+    const updateSuggestions = (
+        text: string,
+        kind: 'airport' | 'airline',
+        setOptions: (options: any[]) => void
+    ) => {
+        clearTimeout(suggestTimers.current[kind]);
+        const seq = (suggestSeq.current[kind] ?? 0) + 1;
+        suggestSeq.current[kind] = seq;
+        if (text.trim().length < 2) {
+            setOptions([]);
+            return;
+        }
+        suggestTimers.current[kind] = setTimeout(async () => {
+            let options: any[] = [];
+            try {
+                const suggestions = await fetchSuggestions(text.trim(), kind);
+                options = suggestions.filter((s: any) => s.iata);
+            } catch {
+                options = [];
+            }
+            if (suggestSeq.current[kind] === seq) setOptions(options);
+        }, SUGGEST_DELAY_MS);
+    };
+
     const handleAirlineLookup = async (e: React.FormEvent) => {
         e.preventDefault();
         setAirlineError('');
@@ -74,11 +108,21 @@ export default function IndividualSection() {
                     <input
                         type="text"
                         value={airlineCode}
-                        onChange={(e) => setAirlineCode(e.target.value.toUpperCase())}
-                        placeholder="Airline IATA (e.g., AA)"
-                        maxLength={2}
+                        onChange={(e) => {
+                            setAirlineCode(e.target.value.toUpperCase());
+                            updateSuggestions(e.target.value, 'airline', setAirlineOptions);
+                        }}
+                        placeholder="Airline IATA or name (e.g., AA)"
+                        list="airline-suggestions"
                         style={{ flex: 1, textTransform: 'uppercase' }}
                     />
+                    <datalist id="airline-suggestions">
+                        {airlineOptions.map((s) => (
+                            <option key={s.id} value={s.iata}>
+                                {s.name}{s.city ? ` (${s.city})` : ''}
+                            </option>
+                        ))}
+                    </datalist>
                     <button type="submit" className="btn-primary" disabled={airlineLoading}>
                         {airlineLoading ? 'Searching...' : 'Search'}
                     </button>
@@ -125,11 +169,21 @@ export default function IndividualSection() {
                     <input
                         type="text"
                         value={airportCode}
-                        onChange={(e) => setAirportCode(e.target.value.toUpperCase())}
-                        placeholder="Airport IATA (e.g., SFO)"
-                        maxLength={3}
+                        onChange={(e) => {
+                            setAirportCode(e.target.value.toUpperCase());
+                            updateSuggestions(e.target.value, 'airport', setAirportOptions);
+                        }}
+                        placeholder="Airport IATA, name or city (e.g., SFO)"
+                        list="airport-suggestions"
                         style={{ flex: 1, textTransform: 'uppercase' }}
                     />
+                    <datalist id="airport-suggestions">
+                        {airportOptions.map((s) => (
+                            <option key={s.id} value={s.iata}>
+                                {s.name}{s.city ? ` (${s.city})` : ''}
+                            </option>
+                        ))}
+                    </datalist>
                     <button type="submit" className="btn-primary" disabled={airportLoading}>
                         {airportLoading ? 'Searching...' : 'Search'}
                     </button>
@@ -22,6 +22,52 @@ export async function fetchAirport(iata: string) {
     return data;
 }
 
+// Fetch airline by ICAO code (3 characters)
+export async function fetchAirlineByIcao(icao: string) {
+    const response = await fetch(`${API_BASE}/airline/icao/${icao.toUpperCase()}`);
+    const data = await response.json();
+    if (data.error) {
+        throw new Error(data.error);
+    }
+    return data;
+}
+
+// Fetch airport by ICAO code (4 characters)
+export async function fetchAirportByIcao(icao: string) {
+    const response = await fetch(`${API_BASE}/airport/icao/${icao.toUpperCase()}`);
+    const data = await response.json();
+    if (data.error) {
+        throw new Error(data.error);
+    }
+    return data;
+}
+
+// Resolve many airport/airline codes (IATA or ICAO) in one request
+export async function fetchBulk(airports: string[], airlines: string[] = []) {
+    const response = await fetch(`${API_BASE}/bulk`, {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/json' },
+        body: JSON.stringify({ airports, airlines })
+    });
+    const data = await response.json();
+    if (data.error) {
+        throw new Error(data.error);
+    }
+    return data;
+}
+
+// Typeahead suggestions over airport/airline names, cities and codes
+export async function fetchSuggestions(query: string, kind?: 'airport' | 'airline', k: number = 8) {
+    const params = new URLSearchParams({ q: query, k: String(k), fuzzy: '1' });
+    if (kind) params.set('kind', kind);
+    const response = await fetch(`${API_BASE}/suggest?${params.toString()}`);
+    const data = await response.json();
+    if (data.error) {
+        throw new Error(data.error);
+    }
+    return data.suggestions || [];
+}
+
 // Fetch airlines for a given airport (destination)
 export async function fetchAirlinesForAirport(airportIata: string) {
     const response = await fetch(`${API_BASE}/airlinesForAirport/${airportIata.toUpperCase()}`);
@@ -32,9 +78,9 @@ export async function fetchAirlinesForAirport(airportIata: string) {
     return data.airlines || [];
 }
 
-// Fetch top cities for an airline
-export async function fetchTopCitiesForAirline(airlineIata: string) {
-    const response = await fetch(`${API_BASE}/topCitiesForAirline/${airlineIata.toUpperCase()}`);
+// Fetch top N cities for an airline
+export async function fetchTopCitiesForAirline(airlineIata: string, n: number = 3) {
+    const response = await fetch(`${API_BASE}/topCitiesForAirline/${airlineIata.toUpperCase()}?n=${n}`);
     const data = await response.json();
     if (data.error) {
         throw new Error(data.error);
@@ -253,8 +299,9 @@ export async function fetchAirportReport() {
 }
 
 // Reports: airports served by airline ordered by route count
-export async function fetchAirlineRoutesReport(iata: string) {
-    const response = await fetch(`${API_BASE}/reports/airlineRoutes/${iata.toUpperCase()}`);
+export async function fetchAirlineRoutesReport(iata: string, operatedOnly: boolean = false) {
+    const query = operatedOnly ? '?operatedOnly=true' : '';
+    const response = await fetch(`${API_BASE}/reports/airlineRoutes/${iata.toUpperCase()}${query}`);
     const data = await response.json();
     if (data.error) {
         throw new Error(data.error);
@@ -263,8 +310,9 @@ export async function fetchAirlineRoutesReport(iata: string) {
 }
 
 // Reports: airlines serving airport ordered by route count
-export async function fetchAirportRoutesReport(iata: string) {
-    const response = await fetch(`${API_BASE}/reports/airportRoutes/${iata.toUpperCase()}`);
+export async function fetchAirportRoutesReport(iata: string, operatedOnly: boolean = false) {
+    const query = operatedOnly ? '?operatedOnly=true' : '';
+    const response = await fetch(`${API_BASE}/reports/airportRoutes/${iata.toUpperCase()}${query}`);
     const data = await response.json();
     if (data.error) {
         throw new Error(data.error);
@@ -0,0 +1,328 @@
+// Regression tests for the data engine, run against a small fixture dataset
+// written to a temporary directory. From the repo root:
+//
+//   make test
+
+#include "../engine.h"
+
+#include <cstdlib>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: "   \
+                      << #cond << "\n";                                      \
+            ++failures;                                                      \
+        }                                                                    \
+    } while (0)
+
+void writeFile(const std::string& path, const std::string& text) {
+    std::ofstream out(path);
+    out << text;
+}
+
+// Hop-chain airport i: HAA, HAB, ... (IDs 100 + i).
+std::string chainCode(int i) {
+    return std::string("HA") + static_cast<char>('A' + i);
+}
+
+const int CHAIN_LEN = 16;   // 15 hops end to end, past the matrix's saturation
+
+std::string chainAirports() {
+    std::string rows;
+    for (int i = 0; i < CHAIN_LEN; ++i) {
+        std::string id = std::to_string(100 + i), code = chainCode(i);
+        rows += id + ",\"Hop " + code + "\",\"Hop City\",\"Testland\",\"" + code + "\",\"T" + code
+              + "\",20," + std::to_string(i) + ",0,0,\"N\",\"Etc/UTC\",\"airport\",\"Test\"\n";
+    }
+    return rows;
+}
+
+std::string chainRoutes() {
+    std::string rows;
+    for (int i = 0; i + 1 < CHAIN_LEN; ++i) {
+        rows += "TA,1," + chainCode(i) + "," + std::to_string(100 + i) + ","
+              + chainCode(i + 1) + "," + std::to_string(101 + i) + ",,0,320\n";
+    }
+    return rows;
+}
+
+// Three airports and a rail station; AAA <-> BBB <-> CCC by air, and
+// AAA -> ZDS -> CCC by rail, so the station is a one-hop connection unless
+// the graph is limited to airports. A one-way chain HAA -> HAB -> ... -> HAP
+// exercises hop-count saturation.
+std::string writeFixture() {
+    char dir[] = "/tmp/engine_test_XXXXXX";
+    if (!mkdtemp(dir)) return "";
+    writeFile(std::string(dir) + "/airlines.dat",
+        "1,\"Test Air\",\\N,\"TA\",\"TST\",\"TEST\",\"Testland\",\"Y\"\n");
+    writeFile(std::string(dir) + "/airports.dat",
+        "1,\"Alpha\",\"Alpha City\",\"Testland\",\"AAA\",\"TAAA\",10,10,0,0,\"N\",\"Etc/UTC\",\"airport\",\"Test\"\n"
+        "2,\"Bravo\",\"Bravo City\",\"Testland\",\"BBB\",\"TBBB\",11,11,0,0,\"N\",\"Etc/UTC\",\"airport\",\"Test\"\n"
+        "3,\"Charlie\",\"Charlie City\",\"Testland\",\"CCC\",\"TCCC\",12,12,0,0,\"N\",\"Etc/UTC\",\"airport\",\"Test\"\n"
+        "4,\"Delta Station\",\"Alpha City\",\"Testland\",\"ZDS\",\\N,10.1,10.1,0,0,\"N\",\"Etc/UTC\",\"station\",\"Test\"\n"
+        + chainAirports());
+    writeFile(std::string(dir) + "/routes.dat",
+        "TA,1,AAA,1,BBB,2,,0,320\n"
+        "TA,1,BBB,2,AAA,1,,0,320\n"
+        "TA,1,BBB,2,CCC,3,,0,320\n"
+        "TA,1,CCC,3,BBB,2,,0,320\n"
+        "TA,1,ZDS,4,AAA,1,,0,TRN\n"
+        "TA,1,AAA,1,ZDS,4,,0,TRN\n"
+        "TA,1,ZDS,4,CCC,3,,0,TRN\n"
+        + chainRoutes());
+    return dir;
+}
+
+// ---------- Hop Matrix ----------
+
+// Waits for the analytics worker to publish a matrix for the current version.
+bool waitForHopMatrix() {
+    for (int i = 0; i < 500; ++i) {
+        HopsResult r = queryHops("AAA", "BBB", -1);
+        if (r.ok() && !r.stale) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+void testHopsSameAirport() {
+    HopsResult r = queryHops("AAA", "AAA", 0);
+    CHECK(r.ok() && r.hop.error.empty());
+    CHECK(r.hop.hops == 0);
+    CHECK(r.hop.withinMaxStops == 1);
+}
+
+// HAA -> HAP is 15 hops; the matrix stores "14 or more".
+void testHopsSaturated() {
+    std::string first = chainCode(0), last = chainCode(CHAIN_LEN - 1);
+    HopsResult r = queryHops(first, last, 20);
+    CHECK(r.hop.saturated);
+    CHECK(r.hop.withinMaxStops == -1);
+
+    r = queryHops(first, last, 5);
+    CHECK(r.hop.withinMaxStops == 0);
+
+    r = queryHops(first, chainCode(3), 2);
+    CHECK(r.hop.hops == 3);
+    CHECK(r.hop.withinMaxStops == 1);
+}
+
+// ---------- One Hop ----------
+
+bool hasHub(const OneHopResult& r, const std::string& iata) {
+    for (const OneHopConnection& c : r.connections) {
+        if (c.hubIata == iata) return true;
+    }
+    return false;
+}
+
+// With GRAPH_AIRPORTS_ONLY off (the default) every airport type connects.
+void testOneHopIncludesStations() {
+    OneHopResult r = queryOneHop("AAA", "CCC");
+    CHECK(hasHub(r, "BBB"));
+    CHECK(hasHub(r, "ZDS"));
+    CHECK(r.connections.size() == 2);
+}
+
+void testOneHopAirportsOnly() {
+    OneHopResult r = queryOneHop("AAA", "CCC");
+    CHECK(hasHub(r, "BBB"));
+    CHECK(!hasHub(r, "ZDS"));
+    CHECK(r.connections.size() == 1);
+}
+
+// ---------- Isochrone ----------
+
+void testIsochroneFromAirport() {
+    IsochroneResult r = queryIsochrone({ "AAA" }, std::numeric_limits<double>::infinity(), 1);
+    CHECK(r.ok());
+    bool reached = false;
+    for (const IsochroneAirport& ap : r.airports) reached = reached || ap.iata == "CCC";
+    CHECK(reached);
+}
+
+// Stations have no node in the airports-only route graph.
+void testIsochroneFromStation() {
+    IsochroneResult r = queryIsochrone({ "ZDS" }, std::numeric_limits<double>::infinity(), 1);
+    CHECK(r.error == "Airport not in route graph: ZDS");
+
+    r = queryIsochrone({ "AAA", "ZDS" }, 5000.0, 1);
+    CHECK(r.error == "Airport not in route graph: ZDS");
+}
+
+// ---------- Mutations ----------
+
+size_t poolSize() {
+    std::shared_lock<std::shared_mutex> lock(dataMutex);
+    return strings.size();
+}
+
+// Rejected inserts must not leave strings behind in the pool.
+void testDuplicateInsertKeepsPool() {
+    size_t before = poolSize();
+    AirlineFields airline;
+    airline.name = "Never Interned Air";
+    airline.iata = "NI";
+    airline.callsign = "NEVER";
+    CHECK(addAirline(1, airline).error == "Airline ID already exists");
+    AirportFields airport;
+    airport.name = "Never Interned Field";
+    airport.iata = "NIF";
+    airport.city = "Nowhere";
+    CHECK(addAirport(1, airport).error == "Airport ID already exists");
+    airport.name.reset();
+    CHECK(addAirport(2000, airport).error == "name and iata are required");
+    RouteFields route;
+    route.airlineId = 999;
+    route.srcAirportId = 1;
+    route.dstAirportId = 2;
+    route.equipment = "N3V";
+    CHECK(addRoute(route).error == "Invalid airline ID");
+    route.airlineId = 1;
+    route.dstAirportId = 999;
+    CHECK(addRoute(route).error == "Invalid destination airport ID");
+    CHECK(poolSize() == before);
+}
+
+// Add/delete churn through more distinct airline IDs than there are dense
+// slots; released slots must be reused rather than exhausting the index.
+void testRouteSlotChurn() {
+    const int ROUNDS = 70000;   // > 65536 slots
+    size_t slotsBefore = airlineSlots.size();
+    AirlineFields airline;
+    airline.name = "Churn Air";
+    airline.iata = "";
+    RouteFields route;
+    route.srcAirportId = 1;
+    route.dstAirportId = 3;
+    bool ok = true;
+    for (int i = 0; i < ROUNDS && ok; ++i) {
+        int id = 100000 + i;
+        route.airlineId = id;
+        addAirline(id, airline);
+        ok = addRoute(route).ok();
+        removeAirline(id);
+    }
+    CHECK(ok);
+    {
+        std::shared_lock<std::shared_mutex> lock(dataMutex);
+        CHECK(airlineSlots.size() <= slotsBefore + 1);
+        CHECK(airlineSlots.find(100000) < 0);
+    }
+
+    // the fixture routes still resolve after their neighbours' slots moved
+    AirlineRoutesReportResult r = queryAirlineRoutesReport("TA", false);
+    bool served = false;
+    for (const AirportCount& row : r.airports) served = served || row.iata == "BBB";
+    CHECK(served);
+}
+
+// A route that needs more slots than are left must not claim any of them.
+void testPushBackAllOrNothing() {
+    RouteStore store;
+    for (int id = 0; id < 65535; ++id) store.airportSlots.assign(id);
+    Route r;
+    r.airlineId = 7;
+    r.srcAirportId = 70000;
+    r.dstAirportId = 70001;
+    CHECK(!store.push_back(r));
+    CHECK(store.airlineSlots.find(7) < 0);
+    CHECK(store.airportSlots.find(70000) < 0);
+    CHECK(store.size() == 0);
+
+    r.dstAirportId = 1;
+    CHECK(store.push_back(r));
+    CHECK(store.airportSlots.available() == 0);
+}
+
+// routes.dat with more airport IDs than the store has slots fails the load
+// and leaves the live dataset alone.
+void testOverfullRoutesKeepsDataset(const std::string& fixture) {
+    char dir[] = "/tmp/engine_test_XXXXXX";
+    if (!mkdtemp(dir)) {
+        CHECK(!"cannot create overfull dataset directory");
+        return;
+    }
+    std::string cp = "cp " + fixture + "/airlines.dat " + fixture + "/airports.dat " + dir;
+    std::system(cp.c_str());
+    std::string rows;
+    for (int i = 0; i < 32769; ++i) {   // two fresh airports per route
+        rows += "TA,1,XXX," + std::to_string(200000 + 2 * i) + ",YYY,"
+              + std::to_string(200001 + 2 * i) + ",,0,320\n";
+    }
+    writeFile(std::string(dir) + "/routes.dat", rows);
+
+    size_t before;
+    {
+        std::shared_lock<std::shared_mutex> lock(dataMutex);
+        before = routes.size();
+    }
+    std::string error;
+    CHECK(!loadDataset(dir, &error));
+    CHECK(error.find("65536") != std::string::npos);
+    {
+        std::shared_lock<std::shared_mutex> lock(dataMutex);
+        CHECK(routes.size() == before);
+    }
+    std::string rm = std::string("rm -rf ") + dir;
+    std::system(rm.c_str());
+}
+
+} // namespace
+
+int main() {
+    std::string dir = writeFixture();
+    if (dir.empty()) {
+        std::cerr << "cannot create fixture directory\n";
+        return 1;
+    }
+    if (!loadDataset(dir)) {
+        std::cerr << "cannot load fixture dataset from " << dir << "\n";
+        return 1;
+    }
+    testOneHopIncludesStations();
+
+    // the remaining tests run against the airports-only graph
+    EngineOptions options;
+    options.graphAirportsOnly = true;
+    setEngineOptions(options);
+    if (!loadDataset(dir)) {
+        std::cerr << "cannot reload fixture dataset from " << dir << "\n";
+        return 1;
+    }
+    testOneHopAirportsOnly();
+
+    options.hopMatrix = true;
+    setEngineOptions(options);
+    std::thread analytics(analyticsWorker);
+    if (waitForHopMatrix()) {
+        testHopsSameAirport();
+        testHopsSaturated();
+    } else {
+        CHECK(!"hop matrix was not built");
+    }
+
+    testIsochroneFromAirport();
+    testIsochroneFromStation();
+    testDuplicateInsertKeepsPool();
+    testRouteSlotChurn();
+    testPushBackAllOrNothing();
+    testOverfullRoutesKeepsDataset(dir);
+
+    stopAnalyticsWorker();
+    analytics.join();
+
+    std::string rm = "rm -rf " + dir;
+    std::system(rm.c_str());
+    if (failures) {
+        std::cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cerr << "all engine tests passed\n";
+    return 0;
+}